@@ -58,6 +58,24 @@ constexpr auto run_benchmark  (
       image = &ray_tracer->render_frame();
     });
 
+    // Dynamic tile distribution for comparison with the static partitioning above.
+    if (ray_tracer->get_communicator().rank() == 0)
+      std::cout << "Recording. Processes: " << ray_tracer->get_communicator().size() << ". Iteration: " << iteration << ". Device: " << device_name << ". Metric: " << metric_name << " (dynamic tiles). Image Size: " << image_size[0] << "x" << image_size[1] << ".\n";
+    recorder.record(metric_name + "_dynamic," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
+    {
+      ray_tracer->render_tiles_dynamic(image_size_type(64, 64), [] (const image_type&, const image_size_type&) { });
+    });
+
+    // Cost-weighted static partitioning, including the low resolution pre-pass.
+    if (ray_tracer->get_communicator().rank() == 0)
+      std::cout << "Recording. Processes: " << ray_tracer->get_communicator().size() << ". Iteration: " << iteration << ". Device: " << device_name << ". Metric: " << metric_name << " (balanced). Image Size: " << image_size[0] << "x" << image_size[1] << ".\n";
+    recorder.record(metric_name + "_balanced," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
+    {
+      ray_tracer->balance_load();
+      image = &ray_tracer->render_frame();
+    });
+    ray_tracer->set_load_weights({}, {});
+
     image_size = image_size_type(1448, 1448);
     ray_tracer->set_image_size(image_size);
     if (ray_tracer->get_communicator().rank() == 0)
@@ -2,8 +2,13 @@
 #undef ASTRAY_USE_MPI
 #endif
 
+#include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <astray/api.hpp>
 
@@ -16,7 +21,8 @@ constexpr auto run_benchmark  (
   const settings_type<scalar_type, metric_type, motion_type>& settings   , 
   std::size_t                                                 repeats    , 
   const std::string&                                          device_name,
-  const std::string&                                          metric_name)
+  const std::string&                                          metric_name,
+  const std::string&                                          variant_name = "")
 {
   using ray_tracer_type = ast::ray_tracer<metric_type, motion_type>;
   using image_type      = typename ray_tracer_type::image_type;
@@ -24,6 +30,7 @@ constexpr auto run_benchmark  (
 
   auto              ray_tracer = make_ray_tracer(settings);
   const image_type* image;
+  const auto        name       = variant_name.empty() ? metric_name : metric_name + "," + variant_name;
 
   auto iteration  = 0;
   auto image_size = image_size_type();
@@ -32,7 +39,7 @@ constexpr auto run_benchmark  (
     image_size = image_size_type(240, 135);
     ray_tracer->set_image_size(image_size);
     std::cout << "Recording. Iteration: " << iteration << ". Device: " << device_name << ". Metric: " << metric_name << ". Image Size: " << image_size[0] << "x" << image_size[1] << ".\n";
-    recorder.record(metric_name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
+    recorder.record(name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
     {
       image = &ray_tracer->render_frame();
     });
@@ -40,7 +47,7 @@ constexpr auto run_benchmark  (
     image_size = image_size_type(320, 180);
     ray_tracer->set_image_size(image_size);
     std::cout << "Recording. Iteration: " << iteration << ". Device: " << device_name << ". Metric: " << metric_name << ". Image Size: " << image_size[0] << "x" << image_size[1] << ".\n";
-    recorder.record(metric_name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
+    recorder.record(name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
     {
       image = &ray_tracer->render_frame();
     });
@@ -48,7 +55,7 @@ constexpr auto run_benchmark  (
     image_size = image_size_type(480, 270);
     ray_tracer->set_image_size(image_size);
     std::cout << "Recording. Iteration: " << iteration << ". Device: " << device_name << ". Metric: " << metric_name << ". Image Size: " << image_size[0] << "x" << image_size[1] << ".\n";
-    recorder.record(metric_name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
+    recorder.record(name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
     {
       image = &ray_tracer->render_frame();
     });
@@ -56,7 +63,7 @@ constexpr auto run_benchmark  (
     image_size = image_size_type(960, 540);
     ray_tracer->set_image_size(image_size);
     std::cout << "Recording. Iteration: " << iteration << ". Device: " << device_name << ". Metric: " << metric_name << ". Image Size: " << image_size[0] << "x" << image_size[1] << ".\n";
-    recorder.record(metric_name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
+    recorder.record(name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
     {
       image = &ray_tracer->render_frame();
     });
@@ -64,7 +71,7 @@ constexpr auto run_benchmark  (
     image_size = image_size_type(1920, 1080);
     ray_tracer->set_image_size(image_size);
     std::cout << "Recording. Iteration: " << iteration << ". Device: " << device_name << ". Metric: " << metric_name << ". Image Size: " << image_size[0] << "x" << image_size[1] << ".\n";
-    recorder.record(metric_name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
+    recorder.record(name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[1]), [&]
     {
       image = &ray_tracer->render_frame();
     });
@@ -72,7 +79,7 @@ constexpr auto run_benchmark  (
     //image_size = image_size_type(3840, 2160);
     //ray_tracer->set_image_size(image_size);
     //std::cout << "Recording. Iteration: " << iteration << ". Device: " << device_name << ". Metric: " << metric_name << ". Image Size: " << image_size[0] << "x" << image_size[1] << ".\n";
-    //recorder.record(metric_name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[0]), [&]
+    //recorder.record(name + "," + std::to_string(image_size[0]) + "," + std::to_string(image_size[0]), [&]
     //{
     //  image = &ray_tracer->render_frame();
     //});
@@ -80,11 +87,92 @@ constexpr auto run_benchmark  (
     ++iteration;
   }, repeats);
 
-  image->save("../data/outputs/performance/benchmarks_single_" + device_name + "_" + metric_name + ".png");
+  image->save("../data/outputs/performance/benchmarks_single_" + device_name + "_" + metric_name + (variant_name.empty() ? "" : "_" + variant_name) + ".png");
 
   return session;
 }
 
+// Measures the shading of escaped rays in isolation, as it is negligible next to the integration in run_benchmark. Coherent
+// directions sweep the field of view of a camera in row major order, incoherent ones are random. Cache misses of either
+// path are measured externally, e.g. with perf stat -e cache-misses (host device systems) or Nsight Compute (cuda).
+template <typename scalar_type>
+auto run_shading_benchmark(std::size_t repeats, const std::string& device_name)
+{
+  using pixel_type      = ast::vector3<std::uint8_t>;
+  using image_type      = ast::image<pixel_type>;
+  using image_size_type = typename image_type::size_type;
+  using cubemap_type    = ast::cubemap<pixel_type>;
+  using direction_type  = ast::vector3<scalar_type>;
+  using constants       = ast::constants<scalar_type>;
+
+  const image_type   background("../data/backgrounds/checkerboard_gray.png");
+  const cubemap_type cubemap   (background);
+
+  const thrust::device_vector<pixel_type> device_background = background.data;
+  const thrust::device_vector<pixel_type> device_cubemap    = cubemap   .data();
+  thrust::device_vector<pixel_type>       device_result     (1920 * 1080);
+
+  std::vector<direction_type> coherent_directions  (device_result.size());
+  std::vector<direction_type> incoherent_directions(device_result.size());
+  std::mt19937                          generator            (0);
+  std::normal_distribution<scalar_type> distribution         ;
+  for (auto y = 0; y < 1080; ++y)
+    for (auto x = 0; x < 1920; ++x)
+    {
+      coherent_directions  [x + y * 1920] = direction_type(1, static_cast<scalar_type>(x - 960) / 960, static_cast<scalar_type>(y - 540) / 960);
+      incoherent_directions[x + y * 1920] = direction_type(distribution(generator), distribution(generator), distribution(generator));
+    }
+
+  const auto synchronize = [ ]
+  {
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+    cudaDeviceSynchronize();
+#endif
+  };
+
+  return ast::benchmark<scalar_type, std::milli, std::chrono::high_resolution_clock>([&] (auto& recorder)
+  {
+    for (const auto& [directions, directions_name] : std::vector<std::pair<const std::vector<direction_type>*, std::string>> {
+      {&coherent_directions, "coherent"}, {&incoherent_directions, "incoherent"}})
+    {
+      const thrust::device_vector<direction_type> device_directions = *directions;
+
+      std::cout << "Recording shading. Device: " << device_name << ". Directions: " << directions_name << ".\n";
+      recorder.record("equirectangular," + directions_name, [&]
+      {
+        thrust::for_each(
+          thrust::make_zip_iterator(thrust::make_tuple(device_directions.begin(), device_result.begin())),
+          thrust::make_zip_iterator(thrust::make_tuple(device_directions.end  (), device_result.end  ())),
+          [background = device_background.data().get(), background_size = background.size] __device__ (const auto& iteratee)
+          {
+            const auto&               direction = thrust::get<0>(iteratee);
+            ast::vector4<scalar_type> position (0, direction[0], direction[1], direction[2]);
+            ast::convert<ast::coordinate_system_type::cartesian, ast::coordinate_system_type::spherical>(position);
+
+            image_size_type index(
+              std::floor(position[3] / constants::two_pi * static_cast<scalar_type>(background_size[0])),
+              std::floor(position[2] / constants::pi     * static_cast<scalar_type>(background_size[1])));
+            if (index[1] == background_size[1]) --index[1];
+            thrust::get<1>(iteratee) = background[ast::ravel_multi_index<image_size_type, true>(index, background_size)];
+          });
+        synchronize();
+      });
+      recorder.record("cubemap,"         + directions_name, [&]
+      {
+        thrust::for_each(
+          thrust::make_zip_iterator(thrust::make_tuple(device_directions.begin(), device_result.begin())),
+          thrust::make_zip_iterator(thrust::make_tuple(device_directions.end  (), device_result.end  ())),
+          [data = device_cubemap.data().get(), face_size = cubemap.face_size()] __device__ (const auto& iteratee)
+          {
+            const auto& direction = thrust::get<0>(iteratee);
+            thrust::get<1>(iteratee) = cubemap_type::sample(data, face_size, direction[0], direction[1], direction[2]);
+          });
+        synchronize();
+      });
+    }
+  }, repeats);
+}
+
 std::int32_t main(std::int32_t argc, char** argv)
 {
   constexpr auto runs = 5;
@@ -111,5 +199,48 @@ std::int32_t main(std::int32_t argc, char** argv)
   //stream << run_benchmark(settings_type<scalar_type, ast::metrics::morris_thorne      <scalar_type>>(), runs, device_name, "morris_thorne"      ).to_string();
   stream << run_benchmark(settings_type<scalar_type, ast::metrics::kastor_traschen    <scalar_type>>(), runs, device_name, "kastor_traschen"    ).to_string();
 
+  // Compare the row major pixel order against the space-filling curve orders.
+  std::ofstream order_stream("../data/outputs/performance/benchmark_single_" + device_name + "_pixel_order.csv");
+  order_stream << "metric,order,width,height,";
+  for (auto i = 0; i < runs; ++i)
+    order_stream << "run_" << i << ",";
+  order_stream << "mean,variance,standard deviation\n";
+  for (const auto& [order, order_name] : std::vector<std::pair<ast::space_filling_curve_type, std::string>> {
+    {ast::space_filling_curve_type::row_major, "row_major"},
+    {ast::space_filling_curve_type::morton   , "morton"   },
+    {ast::space_filling_curve_type::hilbert  , "hilbert"  }})
+  {
+    settings_type<scalar_type, ast::metrics::schwarzschild<scalar_type>> schwarzschild_settings;
+    settings_type<scalar_type, ast::metrics::kerr         <scalar_type>> kerr_settings;
+    schwarzschild_settings.pixel_order = order;
+    kerr_settings         .pixel_order = order;
+    order_stream << run_benchmark(schwarzschild_settings, runs, device_name, "schwarzschild", order_name).to_string();
+    order_stream << run_benchmark(kerr_settings         , runs, device_name, "kerr"         , order_name).to_string();
+  }
+
+  // Compare shading from the equirectangular background against shading from its cubemap.
+  std::ofstream background_stream("../data/outputs/performance/benchmark_single_" + device_name + "_background.csv");
+  background_stream << "metric,background,width,height,";
+  for (auto i = 0; i < runs; ++i)
+    background_stream << "run_" << i << ",";
+  background_stream << "mean,variance,standard deviation\n";
+  for (const auto cubemap : {false, true})
+  {
+    settings_type<scalar_type, ast::metrics::schwarzschild<scalar_type>> schwarzschild_settings;
+    settings_type<scalar_type, ast::metrics::kerr         <scalar_type>> kerr_settings;
+    schwarzschild_settings.background_path = kerr_settings.background_path = "../data/backgrounds/checkerboard_gray.png";
+    schwarzschild_settings.cubemap         = kerr_settings.cubemap         = cubemap;
+    const auto background_name = cubemap ? "cubemap" : "equirectangular";
+    background_stream << run_benchmark(schwarzschild_settings, runs, device_name, "schwarzschild", background_name).to_string();
+    background_stream << run_benchmark(kerr_settings         , runs, device_name, "kerr"         , background_name).to_string();
+  }
+
+  std::ofstream shading_stream("../data/outputs/performance/benchmark_single_" + device_name + "_shading.csv");
+  shading_stream << "background,directions,";
+  for (auto i = 0; i < runs; ++i)
+    shading_stream << "run_" << i << ",";
+  shading_stream << "mean,variance,standard deviation\n";
+  shading_stream << run_shading_benchmark<scalar_type>(runs, device_name).to_string();
+
   return 0;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <filesystem>
 
 #include <astray/api.hpp>
 
@@ -19,6 +20,8 @@ struct settings_type
   using transform_type       = typename observer_type  ::transform_type;
   using projection_type      = typename observer_type  ::projection_type;
   using vector_type          = typename transform_type ::vector_type;
+  using pixel_order_type     = ast::space_filling_curve_type;
+  using path_type            = std::filesystem::path;
   
   image_size_type      image_size       = {1920, 1080};
   metric_type          metric           = {};
@@ -28,13 +31,20 @@ struct settings_type
   bounds_type          bounds           = {};
   error_evaluator_type error_evaluator  = {};
   bool                 debug            = false;
+  bool                 compressed       = false; // If set, the blocks are run length coded before they are gathered.
+  ast::thread_affinity thread_affinity  = ast::thread_affinity::none; // The pinning of the threads of OpenMP device systems.
+  path_type            render_cache     = {}; // If set, the frames and endpoints of known scenes are served from this directory.
 
   vector_type          position         = vector_type(5, 0, 0);
   vector_type          rotation         = vector_type(0, 0, 0);
   bool                 look_at_origin   = true;
   scalar_type          coordinate_time  = static_cast<scalar_type>(0);
   projection_type      projection       = ast::perspective_projection<scalar_type> {ast::to_radians<scalar_type>(120), static_cast<scalar_type>(image_size[0]) / image_size[1]};
+  pixel_order_type     pixel_order      = pixel_order_type::row_major;
   image_type           background_image = image_type();
+  path_type            background_path  = {}; // If set, the background is memory mapped from the decoded cache of this image instead.
+  bool                 cubemap          = false; // If set, escaped rays are shaded from a cubemap resampled from the background.
+  bool                 anti_aliased     = false; // If set, rays carry differentials which select the level of a mip pyramid of the background.
 };
 
 template <typename scalar_type, typename metric_type, typename motion_type>
@@ -59,6 +69,17 @@ constexpr auto make_ray_tracer(const settings_type<scalar_type, metric_type, mot
     ray_tracer->get_observer().get_transform().look_at(ast::transform<scalar_type>::vector_type::Zero());
   ray_tracer->get_observer().set_coordinate_time(settings.coordinate_time);
   ray_tracer->get_observer().set_projection     (settings.projection);
-  ray_tracer->set_background(settings.background_image);
+  ray_tracer->get_observer().set_pixel_order    (settings.pixel_order);
+  if (settings.background_path.empty())
+    ray_tracer->set_background(settings.background_image);
+  else
+    ray_tracer->set_background(ast::ray_tracer<metric_type, motion_type>::mapped_image_type::load_cached(settings.background_path));
+  ray_tracer->set_anti_aliased(settings.anti_aliased);
+  ray_tracer->set_gather_compressed(settings.compressed);
+  ray_tracer->set_thread_affinity  (settings.thread_affinity);
+  if (!settings.render_cache.empty())
+    ray_tracer->set_render_cache   (settings.render_cache);
+  if (settings.cubemap)
+    ray_tracer->build_cubemap();
   return ray_tracer;
 }
\ No newline at end of file
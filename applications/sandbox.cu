@@ -10,16 +10,16 @@ using scalar_type = float;
 std::int32_t main(std::int32_t argc, char** argv)
 {
   settings_type<scalar_type, ast::metrics::schwarzschild<scalar_type>> settings;
-  settings.image_size = {960, 540};
-  settings.debug      = true;
-  settings.background_image.load("../data/backgrounds/checkerboard_gray.png");
+  settings.image_size      = {960, 540};
+  settings.debug           = true;
+  settings.background_path = "../data/backgrounds/checkerboard_gray.png";
 
   const auto ray_tracer = make_ray_tracer(settings);
         auto image      = ray_tracer->render_frame();
 
   auto record = ast::benchmark<float, std::milli, std::chrono::high_resolution_clock>([&]
   {
-    image = ray_tracer->render_frame();
+    ray_tracer->render_frame(image);
   }, 1);
   std::cout << "Mean: " << record.mean() << "\n";
   
@@ -16,7 +16,7 @@ std::int32_t main(std::int32_t argc, char** argv)
     settings.iterations       = 40000;
     settings.lambda_step_size = static_cast<scalar_type>(0.001);
     settings.position         = {8, 0, 0};
-    settings.background_image.load("../data/backgrounds/checkerboard_gray.png");
+    settings.background_path  = "../data/backgrounds/checkerboard_gray.png";
     std::get<ast::perspective_projection<scalar_type>>(settings.projection).fov_y = 100;
 
     const auto ray_tracer = make_ray_tracer(settings);
@@ -30,7 +30,7 @@ std::int32_t main(std::int32_t argc, char** argv)
     settings.iterations       = 40000;
     settings.lambda_step_size = static_cast<scalar_type>(0.001);
     settings.position         = {8, 0, 0};
-    settings.background_image.load("../data/backgrounds/checkerboard_gray.png");
+    settings.background_path  = "../data/backgrounds/checkerboard_gray.png";
     std::get<ast::perspective_projection<scalar_type>>(settings.projection).fov_y = 100;
 
     const auto ray_tracer = make_ray_tracer(settings);
@@ -44,7 +44,7 @@ std::int32_t main(std::int32_t argc, char** argv)
     settings.iterations       = 40000;
     settings.lambda_step_size = static_cast<scalar_type>(0.001);
     settings.position         = {8, 0, 0};
-    settings.background_image.load("../data/backgrounds/checkerboard_gray.png");
+    settings.background_path  = "../data/backgrounds/checkerboard_gray.png";
     std::get<ast::perspective_projection<scalar_type>>(settings.projection).fov_y = 100;
 
     const auto ray_tracer = make_ray_tracer(settings);
@@ -58,7 +58,7 @@ std::int32_t main(std::int32_t argc, char** argv)
     settings.iterations       = 40000;
     settings.lambda_step_size = static_cast<scalar_type>(0.001);
     settings.position         = {8, 0, 0};
-    settings.background_image.load("../data/backgrounds/checkerboard_gray.png");
+    settings.background_path  = "../data/backgrounds/checkerboard_gray.png";
     std::get<ast::perspective_projection<scalar_type>>(settings.projection).fov_y = 100;
 
     const auto ray_tracer = make_ray_tracer(settings);
@@ -72,7 +72,7 @@ std::int32_t main(std::int32_t argc, char** argv)
     settings.iterations       = 40000;
     settings.lambda_step_size = static_cast<scalar_type>(0.001);
     settings.position         = {1, 0, 0};
-    settings.background_image.load("../data/backgrounds/checkerboard_gray.png");
+    settings.background_path  = "../data/backgrounds/checkerboard_gray.png";
     std::get<ast::perspective_projection<scalar_type>>(settings.projection).fov_y = 100;
 
     const auto ray_tracer = make_ray_tracer(settings);
@@ -86,7 +86,7 @@ std::int32_t main(std::int32_t argc, char** argv)
     settings.iterations       = 40000;
     settings.lambda_step_size = static_cast<scalar_type>(0.001);
     settings.position         = {5, 0, 0};
-    settings.background_image.load("../data/backgrounds/checkerboard_gray.png");
+    settings.background_path  = "../data/backgrounds/checkerboard_gray.png";
     std::get<ast::perspective_projection<scalar_type>>(settings.projection).fov_y = 100;
 
     const auto ray_tracer = make_ray_tracer(settings);
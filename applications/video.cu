@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <iostream>
+#include <vector>
 
 #include <astray/api.hpp>
 
@@ -10,29 +11,38 @@ using scalar_type = float;
 std::int32_t main(std::int32_t argc, char** argv)
 {
   settings_type<scalar_type, ast::metrics::schwarzschild<scalar_type>> settings;
-  settings.image_size = {960, 540};
-  settings.position   = {5, 0, -5};
-  settings.background_image.load("../data/backgrounds/checkerboard_gray.png");
+  settings.image_size      = {960, 540};
+  settings.position        = {5, 0, -5};
+  settings.background_path = "../data/backgrounds/checkerboard_gray.png";
 
   const auto ray_tracer = make_ray_tracer(settings);
 
-  std::optional<ast::video> video(std::nullopt);
+#ifdef ASTRAY_USE_FFMPEG
+  std::optional<ast::video>     video(std::nullopt);
   if (ray_tracer->get_communicator().rank() == 0)
     video.emplace("../data/outputs/applications/video.mp4", ray_tracer->get_image_size(), 60);
+#else
+  std::optional<ast::raw_video> video(std::nullopt); // Playable as is, or encoded externally e.g. through ffmpeg -i video.y4m.
+  if (ray_tracer->get_communicator().rank() == 0)
+    video.emplace("../data/outputs/applications/video.y4m", ray_tracer->get_image_size(), 60);
+#endif
   
+  // The camera path is known in advance, hence the frames are rendered in parallel over time: under MPI, each rank
+  // renders whole frames, and rank 0 reorders them for the encoder.
   constexpr auto frames(1000);
+  std::vector    transforms(frames, ray_tracer->get_observer().get_transform());
   for (auto i = 0; i < frames; ++i)
+  {
+    transforms[i].translation[2] += 0.01f * static_cast<scalar_type>(i);
+    transforms[i].look_at({0, 0, 0});
+  }
+
+  ray_tracer->render_frames_temporal(transforms, [&] (const decltype(settings)::image_type& image, const std::size_t i)
   {
     if (i % 10 == 0)
       std::cout << i << "/" << frames - 1 << "\n";
-
-    auto image = ray_tracer->render_frame();
-    if (ray_tracer->get_communicator().rank() == 0)
-      video->append(image);
-
-    ray_tracer->get_observer().get_transform().translation[2] += 0.01f;
-    ray_tracer->get_observer().get_transform().look_at({0, 0, 0});
-  }
+    video->append(image);
+  });
 
   return 0;
 }
\ No newline at end of file
@@ -2,18 +2,28 @@
 
 #include <astray/benchmark/benchmark.hpp>
 
+#include <astray/core/endpoint_buffer.hpp>
 #include <astray/core/geodesic.hpp>
 #include <astray/core/metric.hpp>
 #include <astray/core/observer.hpp>
 #include <astray/core/ray_tracer.hpp>
+#include <astray/core/tile_checkpoint.hpp>
 
 #include <astray/math/ode/ode.hpp>
 #include <astray/math/angle.hpp>
 #include <astray/math/constants.hpp>
 #include <astray/math/coordinate_system.hpp>
+#include <astray/math/half.hpp>
 #include <astray/math/linear_algebra.hpp>
+#include <astray/math/space_filling_curve.hpp>
 
+#include <astray/media/cubemap.hpp>
 #include <astray/media/image.hpp>
+#include <astray/media/mapped_image.hpp>
+#include <astray/media/mip_pyramid.hpp>
+#include <astray/media/raw_video.hpp>
+#include <astray/media/shared_memory_video.hpp>
+#include <astray/media/tiled_image_writer.hpp>
 #include <astray/media/video.hpp>
 
 #include <astray/metrics/boyer_lindquist/kerr.hpp>
@@ -36,4 +46,7 @@
 #include <astray/metrics/spherical/schwarzschild_cosmic_string.hpp>
 
 #include <astray/parallel/distributed_device.hpp>
-#include <astray/parallel/shared_device.hpp>
\ No newline at end of file
+#include <astray/parallel/run_length.hpp>
+#include <astray/parallel/shared_device.hpp>
+#include <astray/parallel/threading.hpp>
+#include <astray/parallel/weighted_partitioner.hpp>
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <astray/core/termination_reason.hpp>
+#include <astray/math/half.hpp>
+#include <astray/math/indexing.hpp>
+#include <astray/math/linear_algebra.hpp>
+#include <astray/utility/memory_mapped_file.hpp>
+
+namespace ast
+{
+// The exit direction of a ray relative to the observer in spherical angles (only valid if the ray escaped), and the
+// reason of its termination. Use half as the precision type to halve the size of the buffer.
+template <typename precision_type_ = float>
+struct endpoint
+{
+  using precision_type = precision_type_;
+
+  precision_type     theta       {};
+  precision_type     phi         {};
+  termination_reason termination = termination_reason::none;
+};
+
+template <typename precision_type = float>
+class endpoint_buffer
+{
+public:
+  using endpoint_type = endpoint<precision_type>;
+  using storage_type  = std::vector<endpoint_type>;
+  using size_type     = vector2<std::int32_t>;
+
+  struct header
+  {
+    char          magic           [8] = {'A', 'S', 'T', 'R', 'A', 'Y', 'E', 'P'};
+    std::uint32_t version             = 1;
+    std::uint32_t precision_size      = sizeof(precision_type);
+    std::uint32_t endpoint_size       = sizeof(endpoint_type);
+    std::int32_t  size            [2] = {0, 0};
+  };
+
+  explicit endpoint_buffer  (const size_type& size = {32, 32}) : data(size.prod()), size(size)
+  {
+
+  }
+  explicit endpoint_buffer  (const std::filesystem::path& filepath)
+  {
+    load(filepath);
+  }
+  endpoint_buffer           (const endpoint_buffer&  that) = default;
+  endpoint_buffer           (      endpoint_buffer&& temp) = default;
+ ~endpoint_buffer           ()                             = default;
+  endpoint_buffer& operator=(const endpoint_buffer&  that) = default;
+  endpoint_buffer& operator=(      endpoint_buffer&& temp) = default;
+
+  constexpr       endpoint_type& at(const size_type& index)
+  {
+    return data[ravel_multi_index<size_type, true>(index, size)];
+  }
+  constexpr const endpoint_type& at(const size_type& index) const
+  {
+    return data[ravel_multi_index<size_type, true>(index, size)];
+  }
+
+  void load(const std::filesystem::path& filepath)
+  {
+    if (!exists(filepath))
+      throw std::runtime_error("File does not exist!");
+
+    const memory_mapped_file file(filepath);
+    if (file.size() < sizeof(header))
+      throw std::runtime_error("Invalid endpoint buffer!");
+
+    header expected, actual;
+    std::memcpy(&actual, file.data(), sizeof(header));
+    if (std::memcmp(actual.magic, expected.magic, sizeof(expected.magic)) != 0 ||
+        actual.version        != expected.version        ||
+        actual.precision_size != expected.precision_size ||
+        actual.endpoint_size  != expected.endpoint_size  )
+      throw std::runtime_error("Invalid endpoint buffer!");
+
+    // The dimensions are validated against the file size before the buffer is modified, without overflowing.
+    const auto capacity = (file.size() - sizeof(header)) / sizeof(endpoint_type);
+    if (actual.size[0] <= 0 || actual.size[1] <= 0 ||
+        static_cast<std::size_t>(actual.size[0]) > capacity / static_cast<std::size_t>(actual.size[1]) ||
+        file.size() != sizeof(header) + static_cast<std::size_t>(actual.size[0]) * static_cast<std::size_t>(actual.size[1]) * sizeof(endpoint_type))
+      throw std::runtime_error("Invalid endpoint buffer!");
+
+    storage_type loaded(static_cast<std::size_t>(actual.size[0]) * static_cast<std::size_t>(actual.size[1]));
+    std::memcpy(loaded.data(), file.data() + sizeof(header), loaded.size() * sizeof(endpoint_type));
+    data = std::move(loaded);
+    size = size_type(actual.size[0], actual.size[1]);
+  }
+  void save(const std::filesystem::path& filepath) const
+  {
+    header header;
+    header.size[0] = size[0];
+    header.size[1] = size[1];
+
+    memory_mapped_file file(filepath, sizeof(header) + data.size() * sizeof(endpoint_type));
+    std::memcpy(file.data()                 , &header    , sizeof(header));
+    std::memcpy(file.data() + sizeof(header), data.data(), data.size() * sizeof(endpoint_type));
+  }
+
+  storage_type data;
+  size_type    size;
+};
+}
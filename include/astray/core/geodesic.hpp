@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
 #include <astray/core/termination_reason.hpp>
 #include <astray/math/ode/ode.hpp>
 #include <astray/math/linear_algebra.hpp>
@@ -24,7 +28,8 @@ public:
     const scalar_type           lambda_step_size, 
     const scalar_type           lambda          = static_cast<scalar_type>(0),
     const bounds_type&          bounds          = bounds_type(),
-    const error_evaluator_type& error_evaluator = error_evaluator_type())
+    const error_evaluator_type& error_evaluator = error_evaluator_type(),
+    std::size_t*                steps           = nullptr) // If set, receives the number of steps taken.
   {
     using value_type    = vector<scalar_type, 8>;
     using method_type   = explicit_method<tableau_type>;
@@ -55,6 +60,98 @@ public:
     for (std::size_t iteration = 0; iteration < iterations; ++iteration)
     {
       ++iterator;
+      if (steps)
+        *steps = iteration + 1;
+
+      auto termination = metric.check_termination(ray.position, ray.direction);
+      if (termination != termination_reason::none)
+        return termination;
+      if (!bounds.isEmpty() && !bounds.contains(ray.position))
+        return termination_reason::out_of_bounds;
+      if (ray.position.hasNaN() || ray.direction.hasNaN())
+        return termination_reason::numeric_error;
+    }
+        
+    return termination_reason::none;
+  }
+  
+  // Integrates the ray along with its differentials, which follow the geodesic deviation equation linearized in
+  // coordinates: J'' = -dGamma(J)(u, u) - 2 Gamma(u, J'). The derivative of the Christoffel symbols along J is a forward
+  // difference, hence each evaluation costs three Christoffel symbol evaluations instead of one.
+  template <typename ray_type, typename differentials_type, typename metric_type>
+  __device__ static constexpr termination_reason integrate(
+    ray_type&                   ray             ,
+    differentials_type&         differentials   ,
+    const metric_type&          metric          ,
+    const std::size_t           iterations      , 
+    const scalar_type           lambda_step_size, 
+    const scalar_type           lambda          = static_cast<scalar_type>(0),
+    const bounds_type&          bounds          = bounds_type(),
+    const error_evaluator_type& error_evaluator = error_evaluator_type())
+  {
+    using value_type    = vector<scalar_type, 24>; // Position, direction, then the position and direction differentials.
+    using method_type   = explicit_method<tableau_type>;
+    using problem_type  = initial_value_problem<scalar_type, value_type, device_function<value_type(scalar_type, const value_type&)>>;
+    using iterator_type = adaptive_step_iterator<method_type, problem_type, error_evaluator_type>;
+
+    value_type value;
+    value << ray.position, ray.direction, differentials.position[0], differentials.direction[0], differentials.position[1], differentials.direction[1];
+
+    iterator_type iterator 
+    {
+      {
+        lambda,
+        value ,
+        [&metric] __device__ (const scalar_type t, const value_type& y)
+        {
+          value_type dydt;
+          dydt.head(4) = y.segment(4, 4);
+          const auto christoffel_symbols = metric.christoffel_symbols(y.head(4));
+          for (auto i = 0; i < 4; ++i)
+            for (auto j = 0; j < 4; ++j)
+              for (auto k = 0; k < 4; ++k)
+                dydt.segment(4, 4)[k] -= christoffel_symbols(i, j, k) * y.segment(4, 4)[i] * y.segment(4, 4)[j];
+
+          for (auto d = 0; d < 2; ++d)
+          {
+            const auto offset = 8 + 8 * d;
+            dydt.segment(offset, 4) = y.segment(offset + 4, 4);
+
+            const auto length = y.segment(offset, 4).norm();
+            const auto shift  = std::sqrt(std::numeric_limits<scalar_type>::epsilon()) * (static_cast<scalar_type>(1) + y.head(4).norm());
+            const auto scale  = length > static_cast<scalar_type>(0) ? shift / length : static_cast<scalar_type>(0);
+            const auto shifted_christoffel_symbols = scale > static_cast<scalar_type>(0) 
+              ? metric.christoffel_symbols((y.head(4) + scale * y.segment(offset, 4)).eval()) 
+              : christoffel_symbols;
+
+            for (auto i = 0; i < 4; ++i)
+              for (auto j = 0; j < 4; ++j)
+                for (auto k = 0; k < 4; ++k)
+                {
+                  const auto derivative = scale > static_cast<scalar_type>(0) ? (shifted_christoffel_symbols(i, j, k) - christoffel_symbols(i, j, k)) / scale : static_cast<scalar_type>(0);
+                  dydt.segment(offset + 4, 4)[k] -= 
+                    derivative                       * y.segment(4, 4)[i] * y.segment(4         , 4)[j] + 
+                    2 * christoffel_symbols(i, j, k) * y.segment(4, 4)[i] * y.segment(offset + 4, 4)[j];
+                }
+          }
+          return dydt;
+        }
+      }, 
+      lambda_step_size, 
+      error_evaluator
+    };
+    
+    for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+    {
+      ++iterator;
+
+      const auto& y              = iterator.problem.value;
+      ray.position               = y.segment( 0, 4);
+      ray.direction              = y.segment( 4, 4);
+      differentials.position [0] = y.segment( 8, 4);
+      differentials.direction[0] = y.segment(12, 4);
+      differentials.position [1] = y.segment(16, 4);
+      differentials.direction[1] = y.segment(20, 4);
 
       auto termination = metric.check_termination(ray.position, ray.direction);
       if (termination != termination_reason::none)
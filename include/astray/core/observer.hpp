@@ -1,8 +1,12 @@
 #pragma once
 
+#include <stdexcept>
+#include <vector>
+
 #include <astray/math/indexing.hpp>
 #include <astray/math/projection.hpp>
 #include <astray/math/ray.hpp>
+#include <astray/math/space_filling_curve.hpp>
 #include <astray/math/transform.hpp>
 #include <astray/parallel/thrust.hpp>
 
@@ -12,12 +16,13 @@ template <typename scalar_type>
 class observer
 {
 public:
-  using transform_type  = transform <scalar_type>;
-  using projection_type = projection<scalar_type>;
-  using ray_type        = ray<vector4<scalar_type>>;
+  using transform_type     = transform <scalar_type>;
+  using projection_type    = projection<scalar_type>;
+  using ray_type           = ray              <vector4<scalar_type>>;
+  using differentials_type = ray_differentials<vector4<scalar_type>>;
 
-  using vector_type     = typename transform_type::vector_type;
-  using image_size_type = vector2<std::int32_t>;
+  using vector_type        = typename transform_type::vector_type;
+  using image_size_type    = vector2<std::int32_t>;
 
   struct device_data_perspective
   {
@@ -29,6 +34,7 @@ public:
     image_size_type local_size     ;
     image_size_type local_offset   ;
     scalar_type     coordinate_time;
+    std::uint32_t*  pixel_indices  ;
   };
   struct device_data_orthographic
   {
@@ -40,6 +46,7 @@ public:
     image_size_type local_size     ;
     image_size_type local_offset   ;
     scalar_type     coordinate_time;
+    std::uint32_t*  pixel_indices  ;
   };
   
   thrust::device_vector<ray_type>& generate_rays(
@@ -47,95 +54,147 @@ public:
     const image_size_type& local_size  ,
     const image_size_type& local_offset)
   {
-    const auto linear_size = local_size.prod();
+    return generate_rays(global_size, local_size, local_offset, {transform_}, {coordinate_time_});
+  }
+  // Generates the rays of multiple views of the same projection in a single pass, one view after another.
+  thrust::device_vector<ray_type>& generate_rays(
+    const image_size_type&             global_size     ,
+    const image_size_type&             local_size      ,
+    const image_size_type&             local_offset    ,
+    const std::vector<transform_type>& transforms      ,
+    const std::vector<scalar_type>&    coordinate_times)
+  {
+    const auto linear_size = local_size.prod() * transforms.size();
     if (rays_.size() != linear_size)
       rays_.resize(linear_size);
+    if (!ray_differentials_)
+      differentials_.clear();
+    else if (differentials_.size() != linear_size)
+      differentials_.resize(linear_size);
+
+    if (pixel_order_ == space_filling_curve_type::row_major)
+      pixel_indices_.clear();
+    else if (pixel_indices_size_ != local_size || pixel_indices_order_ != pixel_order_)
+      pixel_indices_ = traversal_order<image_size_type, true>(local_size, pixel_order_, pixel_tile_size_);
+    pixel_indices_size_  = local_size;
+    pixel_indices_order_ = pixel_order_;
 
     if (std::holds_alternative<perspective_projection<scalar_type>>(projection_))
-      return generate_rays_perspective (global_size, local_size, local_offset);
+      return generate_rays_perspective (global_size, local_size, local_offset, transforms, coordinate_times);
     else
-      return generate_rays_orthographic(global_size, local_size, local_offset);
+      return generate_rays_orthographic(global_size, local_size, local_offset, transforms, coordinate_times);
   }
   
   thrust::device_vector<ray_type>& generate_rays_perspective(
-    const image_size_type& global_size ,
-    const image_size_type& local_size  ,
-    const image_size_type& local_offset)
+    const image_size_type&             global_size     ,
+    const image_size_type&             local_size      ,
+    const image_size_type&             local_offset    ,
+    const std::vector<transform_type>& transforms      ,
+    const std::vector<scalar_type>&    coordinate_times)
   {
     const auto&       cast_projection = std::get<perspective_projection<scalar_type>>(projection_);
     const scalar_type v_size          = static_cast<scalar_type>(2) * tan(static_cast<scalar_type>(0.5) * cast_projection.fov_y);
     const scalar_type u_size          = v_size * cast_projection.aspect_ratio;
 
-    const vector_type u               = transform_.right  () * u_size;
-    const vector_type v               = transform_.up     () * v_size;
-    const vector_type w               = transform_.forward() * cast_projection.focal_length;
-    const vector_type direction_00    = w - static_cast<scalar_type>(0.5) * u + static_cast<scalar_type>(0.5) * v;
-
-    device_data_perspective device_data
+    std::vector<device_data_perspective> device_data(transforms.size());
+    for (std::size_t i = 0; i < transforms.size(); ++i)
     {
-      transform_.translation,
-      direction_00         ,
-      u                    ,
-      v                    ,
-      global_size          ,
-      local_size           ,
-      local_offset         ,
-      coordinate_time_
-    };
-    thrust::copy_n(&device_data, 1, perspective_data_.begin());
+      const vector_type u             = transforms[i].right  () * u_size;
+      const vector_type v             = transforms[i].up     () * v_size;
+      const vector_type w             = transforms[i].forward() * cast_projection.focal_length;
+      const vector_type direction_00  = w - static_cast<scalar_type>(0.5) * u + static_cast<scalar_type>(0.5) * v;
+
+      device_data[i] = device_data_perspective
+      {
+        transforms[i].translation,
+        direction_00            ,
+        u                       ,
+        v                       ,
+        global_size             ,
+        local_size              ,
+        local_offset            ,
+        coordinate_times[i]     ,
+        pixel_indices_.empty() ? nullptr : pixel_indices_.data().get()
+      };
+    }
+    perspective_data_ = device_data;
 
     thrust::for_each(
       thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(0)           , rays_.begin())),
       thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(rays_.size()), rays_.end  ())),
-      [data = perspective_data_.data().get()] __device__ (const auto& iteratee)
+      [views = perspective_data_.data().get(), view_size = static_cast<std::size_t>(local_size.prod()), differentials = differentials_pointer()] __device__ (const auto& iteratee)
       {
-        const auto local_index        = thrust::get<0>(iteratee);
+        const auto data               = views + thrust::get<0>(iteratee) / view_size;
+        const auto view_index         = thrust::get<0>(iteratee) % view_size;
+        const auto local_index        = data->pixel_indices ? data->pixel_indices[view_index] : view_index;
         const auto local_multi_index  = unravel_index<image_size_type, true>(local_index, data->local_size);
         const auto global_multi_index = local_multi_index + data->local_offset;
 
-        const auto direction          = (data->direction_00
+        const vector_type unnormalized = data->direction_00
           + data->u * static_cast<scalar_type>(global_multi_index[0]) / static_cast<scalar_type>(data->global_size[0])
-          - data->v * static_cast<scalar_type>(global_multi_index[1]) / static_cast<scalar_type>(data->global_size[1])).normalized();
+          - data->v * static_cast<scalar_type>(global_multi_index[1]) / static_cast<scalar_type>(data->global_size[1]);
+        const vector_type direction    = unnormalized.normalized();
 
         auto& ray             = thrust::get<1>(iteratee);
         ray.position [0]      = data->coordinate_time;
         ray.position .tail(3) = data->position;
         ray.direction[0]      = static_cast<scalar_type>(-1);
         ray.direction.tail(3) = direction;
+
+        if (differentials) // Derivatives of the normalized direction.
+        {
+          const vector_type du = data->u / static_cast<scalar_type>(data->global_size[0]);
+          const vector_type dv = data->v / static_cast<scalar_type>(data->global_size[1]);
+
+          auto& differential = differentials[thrust::get<0>(iteratee)];
+          differential                      = differentials_type();
+          differential.direction[0].tail(3) =  (du - direction * direction.dot(du)) / unnormalized.norm();
+          differential.direction[1].tail(3) = -(dv - direction * direction.dot(dv)) / unnormalized.norm();
+        }
       });
 
     return rays_;
   }
 
   thrust::device_vector<ray_type>& generate_rays_orthographic(
-    const image_size_type& global_size ,
-    const image_size_type& local_size  ,
-    const image_size_type& local_offset)
+    const image_size_type&             global_size     ,
+    const image_size_type&             local_size      ,
+    const image_size_type&             local_offset    ,
+    const std::vector<transform_type>& transforms      ,
+    const std::vector<scalar_type>&    coordinate_times)
   {
-    const auto&       cast_projection = std::get<orthographic_projection<scalar_type>>(projection_);
-    const vector_type u               = transform_.right() * cast_projection.height * cast_projection.aspect_ratio;
-    const vector_type v               = transform_.up   () * cast_projection.height;
-    const vector_type position_00     = transform_.translation - static_cast<scalar_type>(0.5) * u + static_cast<scalar_type>(0.5) * v;
+    const auto& cast_projection = std::get<orthographic_projection<scalar_type>>(projection_);
 
-    device_data_orthographic device_data
+    std::vector<device_data_orthographic> device_data(transforms.size());
+    for (std::size_t i = 0; i < transforms.size(); ++i)
     {
-      transform_.forward(),
-      position_00        ,
-      u                  ,
-      v                  ,
-      global_size        ,
-      local_size         ,
-      local_offset       ,
-      coordinate_time_
-    };
-    thrust::copy_n(&device_data, 1, orthographic_data_.begin());
+      const vector_type u           = transforms[i].right() * cast_projection.height * cast_projection.aspect_ratio;
+      const vector_type v           = transforms[i].up   () * cast_projection.height;
+      const vector_type position_00 = transforms[i].translation - static_cast<scalar_type>(0.5) * u + static_cast<scalar_type>(0.5) * v;
+
+      device_data[i] = device_data_orthographic
+      {
+        transforms[i].forward(),
+        position_00           ,
+        u                     ,
+        v                     ,
+        global_size           ,
+        local_size            ,
+        local_offset          ,
+        coordinate_times[i]   ,
+        pixel_indices_.empty() ? nullptr : pixel_indices_.data().get()
+      };
+    }
+    orthographic_data_ = device_data;
     
     thrust::for_each(
       thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(0)           , rays_.begin())),
       thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(rays_.size()), rays_.end  ())),
-      [data = orthographic_data_.data().get()] __device__ (const auto& iteratee)
+      [views = orthographic_data_.data().get(), view_size = static_cast<std::size_t>(local_size.prod()), differentials = differentials_pointer()] __device__ (const auto& iteratee)
       {
-        const auto local_index        = thrust::get<0>(iteratee);
+        const auto data               = views + thrust::get<0>(iteratee) / view_size;
+        const auto view_index         = thrust::get<0>(iteratee) % view_size;
+        const auto local_index        = data->pixel_indices ? data->pixel_indices[view_index] : view_index;
         const auto local_multi_index  = unravel_index<image_size_type, true>(local_index, data->local_size);
         const auto global_multi_index = local_multi_index + data->local_offset;
         
@@ -148,6 +207,14 @@ public:
         ray.position .tail(3) = position;
         ray.direction[0]      = static_cast<scalar_type>(-1);
         ray.direction.tail(3) = data->direction;
+
+        if (differentials)
+        {
+          auto& differential = differentials[thrust::get<0>(iteratee)];
+          differential                     = differentials_type();
+          differential.position[0].tail(3) =  data->u / static_cast<scalar_type>(data->global_size[0]);
+          differential.position[1].tail(3) = -data->v / static_cast<scalar_type>(data->global_size[1]);
+        }
       });
 
     return rays_;
@@ -188,13 +255,62 @@ public:
     projection_ = value;
   }
 
+  space_filling_curve_type         get_pixel_order    () const
+  {
+    return pixel_order_;
+  }
+  // The tile size of the curves must be a power of two, as their decoding spans square tiles of power of two sides.
+  void                             set_pixel_order    (const space_filling_curve_type value, const std::size_t tile_size = 8)
+  {
+    if (tile_size == 0 || (tile_size & (tile_size - 1)) != 0)
+      throw std::runtime_error("The tile size of the pixel order is not a power of two.");
+
+    pixel_order_     = value;
+    pixel_tile_size_ = tile_size;
+    pixel_indices_size_.setZero(); // Force regeneration of the pixel indices.
+  }
+
+  // If set, generate_rays also generates the differentials of each ray with respect to the pixel coordinates.
+  bool                             get_ray_differentials() const
+  {
+    return ray_differentials_;
+  }
+  void                             set_ray_differentials(const bool             value)
+  {
+    ray_differentials_ = value;
+  }
+  // The differentials of each ray generated by the last call to generate_rays. Empty if ray differentials are disabled.
+  thrust::device_vector<differentials_type>&  get_differentials()
+  {
+    return differentials_;
+  }
+
+  // The local (ravelled) pixel index of each ray generated by the last call to generate_rays.
+  // Empty if the pixel order is row major, in which case the ray index equals the pixel index.
+  const thrust::device_vector<std::uint32_t>& get_pixel_indices  () const
+  {
+    return pixel_indices_;
+  }
+
 protected:
-  scalar_type                                     coordinate_time_   = static_cast<scalar_type>(0);
-  transform_type                                  transform_         { };
-  projection_type                                 projection_        { };
+  differentials_type*                             differentials_pointer()
+  {
+    return ray_differentials_ ? differentials_.data().get() : nullptr;
+  }
+
+  scalar_type                                     coordinate_time_     = static_cast<scalar_type>(0);
+  transform_type                                  transform_           { };
+  projection_type                                 projection_          { };
+  space_filling_curve_type                        pixel_order_         = space_filling_curve_type::row_major;
+  std::size_t                                     pixel_tile_size_     = 8;
+  bool                                            ray_differentials_   = false;
 
-  thrust::device_vector<ray_type>                 rays_              { };
-  thrust::device_vector<device_data_perspective>  perspective_data_  {1};
-  thrust::device_vector<device_data_orthographic> orthographic_data_ {1};
+  thrust::device_vector<ray_type>                 rays_                { };
+  thrust::device_vector<differentials_type>       differentials_       { };
+  thrust::device_vector<std::uint32_t>            pixel_indices_       { };
+  image_size_type                                 pixel_indices_size_  = image_size_type::Zero();
+  space_filling_curve_type                        pixel_indices_order_ = space_filling_curve_type::row_major;
+  thrust::device_vector<device_data_perspective>  perspective_data_    {1};
+  thrust::device_vector<device_data_orthographic> orthographic_data_   {1};
 };
 }
\ No newline at end of file
@@ -1,18 +1,41 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <limits>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
 #include <vector>
 
+#include <astray/core/endpoint_buffer.hpp>
 #include <astray/core/geodesic.hpp>
 #include <astray/core/observer.hpp>
+#include <astray/core/tile_checkpoint.hpp>
 #include <astray/math/constants.hpp>
 #include <astray/math/coordinate_system.hpp>
+#include <astray/media/cubemap.hpp>
 #include <astray/media/image.hpp>
+#include <astray/media/mapped_image.hpp>
+#include <astray/media/mip_pyramid.hpp>
 #include <astray/parallel/mpi/mpi.hpp>
 #include <astray/parallel/partitioner.hpp>
+#include <astray/parallel/run_length.hpp>
+#include <astray/parallel/weighted_partitioner.hpp>
+#include <astray/parallel/shared_device.hpp>
+#include <astray/parallel/threading.hpp>
 #include <astray/parallel/thrust.hpp>
+#include <astray/utility/hash.hpp>
 
 namespace ast
 {
@@ -24,21 +47,33 @@ public:
   using vector_type          = vector4<scalar_type>;
 
   using observer_type        = observer<scalar_type>;
+  using ray_type             = typename observer_type::ray_type;
+  using differentials_type   = typename observer_type::differentials_type;
+  using transform_type       = typename observer_type::transform_type;
 
   using pixel_type           = vector3<std::uint8_t>;
   using image_type           = image<pixel_type>;
   using image_size_type      = image_type::size_type;
+  using mapped_image_type    = mapped_image<pixel_type>;
+  using shared_pixels_type   = mpi::shared_window<pixel_type>;
+  using shared_bytes_type    = mpi::shared_window<std::uint8_t>;
+  using cubemap_type         = cubemap<pixel_type>;
+  using mip_pyramid_type     = mip_pyramid<pixel_type>;
 
   using bounds_type          = typename motion_type::bounds_type;
   using error_evaluator_type = typename motion_type::error_evaluator_type;
 
-  using partitioner_type     = partitioner<2, std::int32_t, image_size_type, true>;
+  using partitioner_type     = weighted_partitioner<2, std::int32_t, image_size_type, true>;
 
   struct device_data
   {
     vector_type          observer_position ;
-    pixel_type*          background        ;
+    const pixel_type*    background        ;
     image_size_type      background_size   ;
+    const pixel_type*    cubemap           ; // If set, escaped rays are shaded from the cubemap instead of the background.
+    std::int32_t         cubemap_face_size ;
+    const pixel_type*    mip_pyramid       ; // If set (along with the differentials), escaped rays are anti-aliased.
+    std::int32_t         mip_level_count   ;
 
     metric_type          metric            ;
     std::size_t          iterations        ;
@@ -51,6 +86,20 @@ public:
     pixel_type*          result            ;
     image_size_type      result_size       ;
     image_size_type      result_offset     ;
+    const std::uint32_t* pixel_indices     ;
+    differentials_type*  differentials     ;
+  };
+
+  // A region of the image in pixels, the max corner is exclusive.
+  using region_type          = aabb2<std::int32_t>;
+
+  // A result buffer of asynchronous rendering.
+  struct async_buffer
+  {
+    thrust::device_vector<pixel_type>     device_result  ;
+    image_type                            result         {image_size_type::Zero().eval()};
+    image_type                            gathered_result{image_size_type::Zero().eval()};
+    std::shared_future<const image_type&> future         ;
   };
 
   explicit ray_tracer  (
@@ -69,7 +118,6 @@ public:
   , bounds_            (bounds)
   , error_evaluator_   (error_evaluator)
   , debug_             (debug)
-  , device_background_ (background_.data)
   , partitioner_       (communicator_.rank(), communicator_.size(), image_size)
   {
 #if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
@@ -80,112 +128,771 @@ public:
       cudaDeviceSetLimit(cudaLimitMallocHeapSize, target_heap_size);
 #endif
 
-#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_OMP
-    omp_set_num_threads(omp_get_num_procs());
+#ifdef ASTRAY_USE_MPI
+    node_communicator_ = communicator_.split_shared();
 #endif
+    update_threads();
+
+    if constexpr (shared_device == shared_device_type::cuda)
+      device_background_ = background_.data;
 
     set_image_size(image_size);
   }
   ray_tracer           (const ray_tracer&  that) = delete ;
-  ray_tracer           (      ray_tracer&& temp) = default;
- ~ray_tracer           ()                        = default;
+  ray_tracer           (      ray_tracer&& temp) = delete ; // Asynchronous frames refer to the tracer.
+ ~ray_tracer           ()
+  {
+    wait_async();
+    for (auto& stage : pipeline_) // Completes the gathers of an unfinished pipeline.
+      stage.request.wait();
+  }
   ray_tracer& operator=(const ray_tracer&  that) = delete ;
-  ray_tracer& operator=(      ray_tracer&& temp) = default;
+  ray_tracer& operator=(      ray_tracer&& temp) = delete ;
   
   const image_type&           render_frame        ()
   {
-    using constants = constants<scalar_type>;
+    wait_async();
+    allocate_results();
+#ifdef ASTRAY_USE_MPI
+    auto& frame = communicator_.rank() == 0 ? gathered_result_ : result_; // Workers return their partial results.
+#else
+    auto& frame = result_;
+#endif
 
-    device_data data 
+    const auto cache_filepath = render_cache_filepath(".qoi", [&] { return scene_hash(); });
+    if (load_cached(cache_filepath, frame))
+      return frame;
+
+    if constexpr (shared_device == shared_device_type::cuda)
     {
-      vector_type(
-        observer_.get_coordinate_time(), 
-        observer_.get_transform().translation[0], 
-        observer_.get_transform().translation[1], 
-        observer_.get_transform().translation[2]),
-      device_background_.data().get(),
-      background_.size               ,
-      metric_                        ,
-      iterations_                    ,
-      lambda_step_size_              ,
-      lambda_                        ,
-      bounds_                        ,
-      //error_evaluator              ,
-      debug_                         ,
-      device_result_.data().get()    ,
-      result_.size                   ,
-      partitioner_.rank_offset()
+      render_block(device_result_.data().get());
+      thrust::copy(device_result_.begin(), device_result_.end(), result_.data.begin());
+    }
+    else
+      render_block(result_.data.data()); // Host device systems shade straight into the result.
+
+#ifdef ASTRAY_USE_MPI
+    gather(result_.data.data(), gathered_result_.data.data(), pixel_data_type_, resized_data_type_);
+#endif
+
+    store_cached(cache_filepath, frame);
+    return frame;
+  }
+  // Renders the frame into the given image, resizing it if necessary. On host device systems, the pixels are shaded
+  // straight into the image without intermediate buffers or copies. Workers receive their partial results.
+  void                        render_frame        (image_type& target)
+  {
+    wait_async();
+    const auto cache_filepath = render_cache_filepath(".qoi", [&] { return scene_hash(); });
+    if (load_cached(cache_filepath, target))
+      return;
+
+    if constexpr (shared_device == shared_device_type::cuda)
+      allocate_results();
+#ifdef ASTRAY_USE_MPI
+    if (communicator_.rank() == 0)
+      allocate_results();
+    auto& block = communicator_.rank() == 0 ? result_ : target; // The target of rank 0 receives the gathered frame.
+#else
+    auto& block = target;
+#endif
+    if (block.size != partitioner_.block_size())
+      block = make_result(partitioner_.block_size());
+
+    if constexpr (shared_device == shared_device_type::cuda)
+    {
+      render_block(device_result_.data().get());
+      thrust::copy(device_result_.begin(), device_result_.end(), block.data.begin());
+    }
+    else
+      render_block(block.data.data());
+
+#ifdef ASTRAY_USE_MPI
+    if (communicator_.rank() == 0 && target.size != partitioner_.domain_size())
+      target = image_type(partitioner_.domain_size(), pixel_type());
+
+    gather(block.data.data(), communicator_.rank() == 0 ? target.data.data() : nullptr, pixel_data_type_, resized_data_type_);
+#endif
+
+    store_cached(cache_filepath, target);
+  }
+
+  // Renders the frame like render_frame, but overlaps the gather of each frame with the computation of the next one: the
+  // gather of this frame is only started, and the gather started by the previous call is completed into the target. The
+  // frames are thereby delayed by one call: returns false if there is no previous frame (or on workers). Call 
+  // finish_pipeline after the last frame to receive it. Without MPI, the frame is rendered into the target directly.
+  bool                        render_frame_pipelined(image_type& target)
+  {
+    wait_async();
+#ifdef ASTRAY_USE_MPI
+    auto& stage     = pipeline_[pipeline_index_];
+    auto& previous  = pipeline_[1 - pipeline_index_];
+    pipeline_index_ = 1 - pipeline_index_;
+
+    if (stage.block.size != partitioner_.block_size())
+      stage.block = image_type(partitioner_.block_size(), pixel_type());
+
+    if constexpr (shared_device == shared_device_type::cuda)
+    {
+      allocate_results();
+      render_block(device_result_.data().get());
+      thrust::copy(device_result_.begin(), device_result_.end(), stage.block.data.begin());
+    }
+    else
+      render_block(stage.block.data.data());
+
+    const auto complete = complete_gather(previous, target);
+    start_gather(stage);
+    return complete;
+#else
+    render_frame(target);
+    return true;
+#endif
+  }
+  // Completes the last frame of pipelined rendering into the target. Returns false if there is none (or on workers).
+  bool                        finish_pipeline     (image_type& target)
+  {
+#ifdef ASTRAY_USE_MPI
+    return complete_gather(pipeline_[1 - pipeline_index_], target);
+#else
+    return false;
+#endif
+  }
+
+  // Renders the frame tile by tile in row major order, passing each complete tile and its offset to the callback, e.g. to
+  // tiled_image_writer::write. Memory use is bounded by the tile size instead of the image size, hence images which do
+  // not fit into memory can be streamed to disk. Each tile is partitioned across the ranks so that their blocks cover it
+  // exactly (see make_tile_partitioner), and only rank 0 receives the gathered tiles.
+  template <typename callback_type>
+  void                        render_tiles        (const image_size_type& tile_size, callback_type&& callback)
+  {
+    wait_async();
+    const auto&           domain_size = partitioner_.domain_size();
+    const image_size_type grid_size   = (domain_size.array() + tile_size.array() - 1) / tile_size.array();
+
+    tile_buffer buffer;
+    for (auto index = 0; index < grid_size.prod(); ++index)
+    {
+      const image_size_type offset = unravel_index<image_size_type, true>(index, grid_size).cwiseProduct(tile_size);
+      if (const auto tile = render_tile(tile_size.cwiseMin(domain_size - offset), offset, buffer))
+        callback(*tile, offset);
+    }
+  }
+
+  // Renders the frame tile by tile like render_tiles, recording the finished tiles in a checkpoint file on rank 0 (see
+  // tile_checkpoint) which is flushed at least once per interval. If the file holds a checkpoint of the same scene (see
+  // scene_hash) and tiling, its tiles are passed to the callback as is, hence an interrupted rendering resumes at the
+  // first missing tile. If endpoints are recorded, the tiles are shaded from their endpoints like shade, and the frame can
+  // be shaded against another background from the checkpoint afterwards. The callback is invoked on rank 0 only.
+  template <typename precision_type = float, typename callback_type>
+  void                        render_tiles_checkpointed(
+    const std::filesystem::path&          filepath                         ,
+    const image_size_type&                tile_size                        ,
+    callback_type&&                       callback                         ,
+    const bool                            endpoints = false                ,
+    const std::chrono::duration<double>   interval  = std::chrono::seconds(60))
+  {
+    wait_async();
+    const auto&           domain_size = partitioner_.domain_size();
+    const image_size_type grid_size   = (domain_size.array() + tile_size.array() - 1) / tile_size.array();
+    const auto            tile_count  = grid_size.prod();
+
+    std::optional<tile_checkpoint<precision_type>> checkpoint;
+    std::vector<std::uint8_t>                      finished(tile_count, 0);
+    if (communicator_.rank() == 0)
+    {
+      checkpoint.emplace(filepath, scene_hash(), domain_size, tile_size, endpoints);
+      for (auto index = 0; index < tile_count; ++index)
+        finished[index] = checkpoint->finished(index) ? 1 : 0;
+    }
+#ifdef ASTRAY_USE_MPI
+    communicator_.bcast(finished.data(), tile_count, mpi::data_type(MPI_BYTE));
+#endif
+
+    tile_buffer buffer;
+    auto        flushed = std::chrono::steady_clock::now();
+    for (auto index = 0; index < tile_count; ++index)
+    {
+      const image_size_type offset = unravel_index<image_size_type, true>(index, grid_size).cwiseProduct(tile_size);
+      const image_size_type extent = tile_size.cwiseMin(domain_size - offset);
+      if (finished[index])
+      {
+        if (checkpoint)
+          callback(static_cast<const image_type&>(checkpoint->tile(index)), offset);
+        continue;
+      }
+
+      if (!endpoints)
+      {
+        if (const auto tile = render_tile(extent, offset, buffer))
+        {
+          checkpoint->write(index, *tile);
+          callback(*tile, offset);
+        }
+      }
+      else
+      {
+        const auto tile_endpoints = render_tile_endpoints<precision_type>(extent, offset);
+        if (checkpoint)
+        {
+          const auto tile = shade(tile_endpoints);
+          checkpoint->write(index, tile, &tile_endpoints);
+          callback(tile, offset);
+        }
+      }
+
+      if (checkpoint && std::chrono::steady_clock::now() - flushed >= interval)
+      {
+        checkpoint->flush();
+        flushed = std::chrono::steady_clock::now();
+      }
+    }
+    if (checkpoint)
+      checkpoint->flush();
+  }
+
+  // Renders the frame tile by tile like render_tiles, but distributes whole tiles dynamically instead of partitioning
+  // each tile: rank 0 hands out tiles on demand and receives the finished ones, hence ranks which trace cheap regions
+  // render more tiles than those which trace the shadow and the photon ring. Each worker holds a prefetched tile while 
+  // rendering and sends its results without blocking. Unless it is dedicated, rank 0 renders tiles itself in between
+  // serving the workers. The callback is invoked on rank 0 only, in the order of completion.
+  template <typename callback_type>
+  void                        render_tiles_dynamic(const image_size_type& tile_size, callback_type&& callback, const bool dedicated_master = false)
+  {
+    wait_async();
+    const auto&           domain_size = partitioner_.domain_size();
+    const image_size_type grid_size   = (domain_size.array() + tile_size.array() - 1) / tile_size.array();
+    const auto            tile_count  = grid_size.prod();
+    const auto            tile_offset = [&] (const std::int32_t index)
+    {
+      return unravel_index<image_size_type, true>(index, grid_size).cwiseProduct(tile_size).eval();
     };
-    thrust::copy_n(&data, 1, device_data_.begin());
-    
-    auto& rays = observer_.generate_rays(partitioner_.domain_size(), partitioner_.block_size(), partitioner_.rank_offset());
+    const auto            tile_extent = [&] (const std::int32_t index)
+    {
+      return tile_size.cwiseMin(domain_size - tile_offset(index)).eval();
+    };
+
+    tile_buffer buffer;
+    if (communicator_.size() == 1)
+    {
+      for (auto index = 0; index < tile_count; ++index)
+        callback(static_cast<const image_type&>(render_local_block(tile_extent(index), tile_offset(index), buffer)), tile_offset(index));
+      return;
+    }
+
+#ifdef ASTRAY_USE_MPI
+    constexpr std::int32_t assignment_tag = 1;
+    constexpr std::int32_t result_tag     = 2;
+    constexpr std::int32_t no_tile        = -1;
+    const mpi::data_type   index_data_type(MPI_INT);
+
+    if (communicator_.rank() == 0)
+    {
+      // Each worker is assigned two tiles ahead, and another one per finished tile. Messages between a pair of ranks do
+      // not overtake each other, hence the results of a worker arrive in the order of its assignments.
+      std::vector<std::vector<std::int32_t>> assigned   (communicator_.size());
+      std::vector<bool>                      terminated (communicator_.size(), false);
+      std::vector<std::int32_t>              assignments(communicator_.size());
+      std::vector<mpi::request>              requests   (communicator_.size());
+      std::int32_t                           next_tile  = 0;
+      std::int32_t                           completed  = 0;
+
+      const auto assign = [&] (const std::int32_t worker)
+      {
+        if (terminated[worker])
+          return;
+
+        requests[worker].wait(); // The assignment buffer is reused.
+        assignments[worker] = next_tile < tile_count ? next_tile++ : no_tile;
+        if (assignments[worker] == no_tile)
+          terminated[worker] = true;
+        else
+          assigned[worker].push_back(assignments[worker]);
+        requests[worker] = communicator_.isend(&assignments[worker], 1, index_data_type, worker, assignment_tag);
+      };
+      const auto receive = [&] (const std::int32_t worker)
+      {
+        const auto index = assigned[worker].front();
+        assigned[worker].erase(assigned[worker].begin());
+
+        auto& tile = buffer.tile;
+        if (tile.size != tile_extent(index))
+          tile = image_type(tile_extent(index), pixel_type());
+        communicator_.recv(tile.data.data(), static_cast<std::int32_t>(tile.data.size()), pixel_data_type_, worker, result_tag);
+
+        assign(worker);
+        callback(static_cast<const image_type&>(tile), tile_offset(index));
+        ++completed;
+      };
+
+      for (auto round = 0; round < 2; ++round)
+        for (auto worker = 1; worker < communicator_.size(); ++worker)
+          assign(worker);
+
+      while (completed < tile_count)
+      {
+        while (const auto worker = communicator_.iprobe(mpi::any_source, result_tag))
+          receive(*worker);
+
+        if (!dedicated_master && next_tile < tile_count)
+        {
+          const auto index = next_tile++;
+          callback(static_cast<const image_type&>(render_local_block(tile_extent(index), tile_offset(index), buffer)), tile_offset(index));
+          ++completed;
+        }
+        else if (completed < tile_count)
+          receive(communicator_.probe(mpi::any_source, result_tag));
+      }
+    }
+    else
+    {
+      std::int32_t index = no_tile, next_index = no_tile;
+      communicator_.recv(&index, 1, index_data_type, 0, assignment_tag);
+
+      image_type   sent(image_size_type::Zero().eval());
+      mpi::request send;
+      while (index != no_tile)
+      {
+        auto prefetch = communicator_.irecv(&next_index, 1, index_data_type, 0, assignment_tag);
+
+        auto& block = render_local_block(tile_extent(index), tile_offset(index), buffer);
+        send.wait();
+        std::swap(sent, block); // The block is sent while the next one is rendered.
+        send = communicator_.isend(sent.data.data(), static_cast<std::int32_t>(sent.data.size()), pixel_data_type_, 0, result_tag);
+
+        prefetch.wait();
+        index = next_index;
+      }
+      send.wait();
+    }
+#endif
+  }
+
+  // Re-renders the given regions of the image into the target, leaving the rest of the target as is. The target is 
+  // resized (and cleared) if it does not match the image size. Regions are clamped to the image, their max corner is
+  // exclusive. Each region is partitioned across the ranks so that their blocks cover it exactly (regardless of its size),
+  // and only rank 0 receives the updated target.
+  void                        render_region       (image_type& target, const region_type& region)
+  {
+    render_regions(target, {region});
+  }
+  void                        render_regions      (image_type& target, const std::vector<region_type>& regions)
+  {
+    wait_async();
+    const auto& domain_size = partitioner_.domain_size();
+    if (communicator_.rank() == 0 && target.size != domain_size)
+      target = image_type(domain_size, pixel_type());
+
+    tile_buffer buffer;
+    for (const auto& region : regions)
+    {
+      const image_size_type min = region.min().cwiseMax(0);
+      const image_size_type max = region.max().cwiseMin(domain_size);
+      if ((max.array() <= min.array()).any())
+        continue;
+
+      if (const auto tile = render_tile(max - min, min, buffer))
+        for (auto y = 0; y < tile->size[1]; ++y)
+          std::copy_n(
+            tile->data.begin() + static_cast<std::size_t>(y) * tile->size[0], tile->size[0], 
+            target.data.begin() + static_cast<std::size_t>(min[0]) + static_cast<std::size_t>(min[1] + y) * domain_size[0]);
+    }
+  }
+
+  // Renders the frame like render_frame, but returns as soon as the block of this rank is traced. Copying the block from
+  // the device and gathering the frame proceed on another thread, so the observer may be updated and the next frame may
+  // be started in the meantime. If MPI does not support calls from other threads (see environment::serialized), the
+  // frame is gathered on the calling thread before returning instead. The results rotate through the async buffers: the
+  // image of a future remains valid until its buffer is reused, get_async_buffer_count() calls later. Workers receive
+  // their partial results. The other collective methods complete the asynchronous frames before communicating.
+  std::shared_future<const image_type&> render_frame_async()
+  {
+    auto&      buffer   = async_buffers_[async_index_];
+    const auto previous = async_buffers_[(async_index_ + async_buffers_.size() - 1) % async_buffers_.size()].future;
+    async_index_        = (async_index_ + 1) % async_buffers_.size();
+
+    if (buffer.future.valid())
+      buffer.future.wait(); // The buffer is reused, hence its previous frame has to be complete.
+    if (buffer.result.size != partitioner_.block_size())
+    {
+      buffer.result          = image_type(partitioner_.block_size(), pixel_type());
+      if constexpr (shared_device == shared_device_type::cuda)
+        buffer.device_result = buffer.result.data;
+#ifdef ASTRAY_USE_MPI
+      buffer.gathered_result = image_type(partitioner_.domain_size());
+#endif
+    }
+
+    if constexpr (shared_device == shared_device_type::cuda)
+      render_block(buffer.device_result.data().get());
+    else
+      render_block(buffer.result.data.data());
+
+    const auto policy = mpi::environment::serialized() ? std::launch::async : std::launch::deferred;
+    buffer.future = std::async(policy, [this, &buffer, previous] () -> const image_type&
+    {
+      if constexpr (shared_device == shared_device_type::cuda)
+        thrust::copy(buffer.device_result.begin(), buffer.device_result.end(), buffer.result.data.begin());
+
+      // Frames complete in order. This also issues the (collective) gathers of all ranks in the same order.
+      if (previous.valid())
+        previous.wait();
+
+#ifdef ASTRAY_USE_MPI
+      gather(buffer.result.data.data(), buffer.gathered_result.data.data(), pixel_data_type_, resized_data_type_);
+
+      if (communicator_.rank() == 0)
+        return buffer.gathered_result;
+#endif
+      return buffer.result;
+    }).share();
+
+    if (policy == std::launch::deferred)
+      buffer.future.wait(); // Runs the gather on the calling thread.
+    return buffer.future;
+  }
+  // Blocks until all asynchronously rendered frames are complete.
+  void                        wait_async          () const
+  {
+    for (auto& buffer : async_buffers_)
+      if (buffer.future.valid())
+        buffer.future.wait();
+  }
+
+  // Renders multiple views of the same projection, such as stereo pairs, cubemap faces or the frames of a camera path, in
+  // a single pass sharing the setup, the ray generation and the integration launches. If the coordinate times are omitted,
+  // the coordinate time of the observer is used for all views. Workers receive their partial results.
+  std::vector<image_type>     render_frames       (const std::vector<transform_type>& transforms, std::vector<scalar_type> coordinate_times = {})
+  {
+    wait_async();
+    if (coordinate_times.empty())
+      coordinate_times.resize(transforms.size(), observer_.get_coordinate_time());
+
+    const auto view_size = static_cast<std::size_t>(partitioner_.block_size().prod());
+
+    std::vector<image_type>  blocks            (transforms.size(), image_type(partitioner_.block_size(), pixel_type()));
+    std::vector<pixel_type*> results           (transforms.size());
+    std::vector<vector_type> observer_positions(transforms.size());
+    thrust::device_vector<pixel_type> device_results;
+    if constexpr (shared_device == shared_device_type::cuda)
+      device_results.resize(view_size * transforms.size(), pixel_type());
+    for (std::size_t i = 0; i < transforms.size(); ++i)
+    {
+      if constexpr (shared_device == shared_device_type::cuda)
+        results         [i] = device_results.data().get() + i * view_size;
+      else
+        results         [i] = blocks[i].data.data(); // Host device systems shade straight into the results.
+      observer_positions[i] = vector_type(coordinate_times[i], transforms[i].translation[0], transforms[i].translation[1], transforms[i].translation[2]);
+    }
+    const thrust::device_vector<pixel_type*> device_result_pointers    = results;
+    const thrust::device_vector<vector_type> device_observer_positions = observer_positions;
+
+    observer_.set_ray_differentials(ray_differentials());
+    auto& rays = observer_.generate_rays(partitioner_.domain_size(), partitioner_.block_size(), partitioner_.rank_offset(), transforms, coordinate_times);
+    upload_device_data(nullptr);
 
     thrust::for_each(
       thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(0)          , rays.begin())),
       thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(rays.size()), rays.end  ())),
-      [data = device_data_.data().get()] __device__ (const auto& iteratee)
+      [data = device_data_.data().get(), results = device_result_pointers.data().get(), observer_positions = device_observer_positions.data().get(), view_size] __device__ (const auto& iteratee)
       {
-        auto  index = thrust::get<0>(iteratee);
-        auto& ray   = thrust::get<1>(iteratee);
-        
-        metric_type metric(data->metric); // A copy is necessary for correct creation of virtual function table.
-        
-        if constexpr (metric_type::coordinate_system() == coordinate_system_type::boyer_lindquist || metric_type::coordinate_system() == coordinate_system_type::prolate_spheroidal)
-          convert_ray<coordinate_system_type::cartesian, metric_type::coordinate_system()>(ray, metric.coordinate_system_parameter());
-        else
-          convert_ray<coordinate_system_type::cartesian, metric_type::coordinate_system()>(ray);
-        
-        const auto termination = motion_type::integrate(ray, metric, data->iterations, data->lambda_step_size, data->lambda, data->bounds); //, data->error_evaluator);
-        
-        if (termination == termination_reason::none || termination == termination_reason::out_of_bounds)
+        const auto view       = thrust::get<0>(iteratee) / view_size;
+        const auto view_index = thrust::get<0>(iteratee) % view_size;
+        const auto index      = data->pixel_indices ? data->pixel_indices[view_index] : view_index;
+        render_pixel(thrust::get<1>(iteratee), thrust::get<0>(iteratee), *data, observer_positions[view], results[view][index]);
+      });
+
+    if constexpr (shared_device == shared_device_type::cuda)
+      for (std::size_t i = 0; i < transforms.size(); ++i)
+        thrust::copy_n(device_results.begin() + i * view_size, view_size, blocks[i].data.begin());
+
+#ifdef ASTRAY_USE_MPI
+    // The gathers of all views are in flight at once instead of one after another.
+    std::vector<pipeline_stage> stages(transforms.size());
+    for (std::size_t i = 0; i < transforms.size(); ++i)
+    {
+      stages[i].block = std::move(blocks[i]);
+      start_gather(stages[i]);
+    }
+
+    std::vector<image_type> images(communicator_.rank() == 0 ? transforms.size() : 0);
+    for (std::size_t i = 0; i < transforms.size(); ++i)
+    {
+      complete_gather(stages[i], communicator_.rank() == 0 ? images[i] : blocks[i]);
+      blocks[i] = std::move(stages[i].block);
+    }
+
+    if (communicator_.rank() == 0)
+      return images;
+#endif
+    return blocks;
+  }
+
+  // Renders the frames of a camera path in parallel over time instead of space: the ranks are split into groups of
+  // group_size ranks, each of which renders whole frames, partitioned across the ranks of the group. Consecutive chunks
+  // of frames_per_group frames are assigned to the groups round robin, hence a group size of one renders each frame on a
+  // single rank without any synchronization, and a group size of the rank count is the usual spatial partitioning. The
+  // blocks are sent to rank 0, which reorders them and passes the complete frames and their indices to the callback in
+  // order, e.g. to append them to an ast::video. Unless it is dedicated, rank 0 renders the frames of its group itself.
+  // Each rank has up to get_async_buffer_count() blocks in flight. The observer is restored afterwards.
+  template <typename callback_type>
+  void                        render_frames_temporal(
+    const std::vector<transform_type>& transforms,
+    callback_type&&                    callback,
+    const std::int32_t                 group_size        = 1,
+    const std::int32_t                 frames_per_group  = 1,
+    const bool                         dedicated_encoder = false,
+    std::vector<scalar_type>           coordinate_times  = {})
+  {
+    wait_async();
+    const auto observer = observer_;
+    if (coordinate_times.empty())
+      coordinate_times.resize(transforms.size(), observer_.get_coordinate_time());
+    const auto set_frame = [&] (const std::size_t frame)
+    {
+      observer_.get_transform() = transforms[frame];
+      observer_.set_coordinate_time(coordinate_times[frame]);
+    };
+
+    if (communicator_.size() == 1)
+    {
+      image_type image;
+      for (std::size_t frame = 0; frame < transforms.size(); ++frame)
+      {
+        set_frame(frame);
+        render_frame(image);
+        callback(static_cast<const image_type&>(image), frame);
+      }
+      observer_ = observer;
+      return;
+    }
+
+#ifdef ASTRAY_USE_MPI
+    const auto first_renderer = dedicated_encoder ? 1 : 0;
+    const auto renderer_count = communicator_.size() - first_renderer;
+    if (group_size < 1 || frames_per_group < 1 || renderer_count % group_size != 0)
+      throw std::runtime_error("The number of rendering ranks is not divisible by the group size.");
+
+    constexpr std::int32_t result_tag  = 3;
+    const auto&            domain_size = partitioner_.domain_size();
+    const auto             group_count = renderer_count / group_size;
+    const auto             group       = [&] (const std::size_t frame)
+    {
+      return static_cast<std::int32_t>(frame / frames_per_group % group_count);
+    };
+
+    const auto             rank        = communicator_.rank();
+    const auto             renderer    = rank >= first_renderer;
+    const auto             own_group   = renderer ? (rank - first_renderer) / group_size : -1;
+    const auto             group_partitioner = make_tile_partitioner(domain_size, renderer ? (rank - first_renderer) % group_size : 0, group_size);
+
+    tile_buffer buffer;
+    if (rank == 0)
+    {
+      // Messages between a pair of ranks do not overtake each other, hence receiving the blocks of each frame from the
+      // ranks of its group in the order of the frames reorders them.
+      image_type frame_image(domain_size, pixel_type());
+      image_type received   (image_size_type::Zero().eval());
+      for (std::size_t frame = 0; frame < transforms.size(); ++frame)
+      {
+        for (auto member = 0; member < group_size; ++member)
         {
-          if constexpr (metric_type::coordinate_system() == coordinate_system_type::boyer_lindquist || metric_type::coordinate_system() == coordinate_system_type::prolate_spheroidal)
-            convert<metric_type::coordinate_system(), coordinate_system_type::cartesian>(ray.position, metric.coordinate_system_parameter());
+          const auto& offset = group_partitioner.block_offsets()[member];
+          const auto& size   = group_partitioner.block_sizes  ()[member];
+          const auto  source = first_renderer + group(frame) * group_size + member;
+
+          const image_type* block = &received;
+          if (source == 0)
+          {
+            set_frame(frame);
+            block = &render_local_block(size, offset, buffer);
+          }
           else
-            convert<metric_type::coordinate_system(), coordinate_system_type::cartesian>(ray.position);
-        
-          ray.position -= data->observer_position; // Environment map is relative to observer.
-          
-          convert<coordinate_system_type::cartesian, coordinate_system_type::spherical>(ray.position);
-          
-          image_size_type background_index(
-            std::floor(ray.position[3] / constants::two_pi * static_cast<scalar_type>(data->background_size[0])),
-            std::floor(ray.position[2] / constants::pi     * static_cast<scalar_type>(data->background_size[1])));
-          if (background_index[1] == data->background_size[1]) --background_index[1];
-          
-          data->result[index] = data->background[ravel_multi_index<image_size_type, true>(background_index, data->background_size)];
-        }
-        
-        if (data->debug)
-        {
-          if      (termination == termination_reason::constraint_violation)
-            data->result[index] = pixel_type(255, 128, 128);
-          else if (termination == termination_reason::numeric_error       )
-            data->result[index] = pixel_type(128, 255, 128);
-          else if (termination == termination_reason::spacetime_breakdown )
-            data->result[index] = pixel_type(128, 128, 255);
+          {
+            if (received.size != size)
+              received = image_type(size, pixel_type());
+            communicator_.recv(received.data.data(), static_cast<std::int32_t>(received.data.size()), pixel_data_type_, source, result_tag);
+          }
+
+          for (auto y = 0; y < size[1]; ++y)
+            std::copy_n(
+              block->data.begin() + static_cast<std::size_t>(y) * size[0], size[0],
+              frame_image.data.begin() + static_cast<std::size_t>(offset[0]) + static_cast<std::size_t>(offset[1] + y) * domain_size[0]);
         }
-      });
+        callback(static_cast<const image_type&>(frame_image), frame);
+      }
+    }
+    else if (renderer)
+    {
+      std::deque<pipeline_stage> sends;
+      for (std::size_t frame = 0; frame < transforms.size(); ++frame)
+      {
+        if (group(frame) != own_group)
+          continue;
+
+        set_frame(frame);
+        auto& block = render_local_block(group_partitioner.block_size(), group_partitioner.rank_offset(), buffer);
+
+        if (sends.size() == async_buffers_.size())
+          sends.pop_front(); // Waits for the oldest send.
+        auto& stage   = sends.emplace_back();
+        stage.block   = block;
+        stage.request = communicator_.isend(stage.block.data.data(), static_cast<std::int32_t>(stage.block.data.size()), pixel_data_type_, 0, result_tag);
+      }
+    }
+#endif
+    observer_ = observer;
+  }
+
+  // Traces the frame like render_frame, but stores the exit direction and the termination reason of each ray instead of
+  // shading it. The result can be shaded against any background through shade, without tracing the geodesics again.
+  template <typename precision_type = float>
+  endpoint_buffer<precision_type> render_endpoints()
+  {
+    using endpoint_type = endpoint<precision_type>;
+
+    wait_async();
+    // Endpoints do not depend on the background, hence are served from the cache across backgrounds.
+    const auto cache_filepath = render_cache_filepath(".bin", [&]
+    {
+      return hasher().add(scene_hash(false)).add(std::uint32_t(sizeof(endpoint_type))).value();
+    });
+    endpoint_buffer<precision_type> cached(image_size_type::Zero().eval());
+    if (load_cached(cache_filepath, cached))
+      return cached;
 
-    thrust::copy(device_result_.begin(), device_result_.end(), result_.data.begin());
+    auto endpoints = trace_endpoints<precision_type>(partitioner_.block_size(), partitioner_.rank_offset());
 
 #ifdef ASTRAY_USE_MPI
-    std::vector<std::int32_t> counts         (communicator_.size(), 1);
-    std::vector<std::int32_t> displacements  (communicator_.size());
-    for (auto y = 0; y < partitioner_.grid_size()[1]; ++y)
-      for (auto x = 0; x < partitioner_.grid_size()[0]; ++x)
-        displacements[x + y * partitioner_.grid_size()[0]] = x + y * (partitioner_.block_size()[1] * partitioner_.grid_size()[0]);
+    const mpi::data_type endpoint_data_type(mpi::data_type(MPI_BYTE), static_cast<std::int32_t>(sizeof(endpoint_type)));
+    const mpi::data_type subarray_data_type(endpoint_data_type, partitioner_.domain_size(), partitioner_.block_size(), image_size_type::Zero().eval(), true);
+    const mpi::data_type resized_data_type (subarray_data_type, 0, partitioner_.block_size()[0] * sizeof(endpoint_type));
 
-    communicator_.gatherv(
-      result_         .data.data(), static_cast<std::int32_t>(result_.data.size()), pixel_data_type_  ,
-      gathered_result_.data.data(), counts.data(), displacements.data()           , resized_data_type_);
+    endpoint_buffer<precision_type> gathered_endpoints(communicator_.rank() == 0 ? partitioner_.domain_size() : image_size_type::Zero().eval());
+    gather(endpoints.data.data(), gathered_endpoints.data.data(), endpoint_data_type, resized_data_type);
 
-    if (communicator_.rank() != 0)
-      return result_; // Workers return their partial results.
-    return gathered_result_;
-#else
-    return result_;
+    if (communicator_.rank() == 0)
+    {
+      store_cached(cache_filepath, gathered_endpoints);
+      return gathered_endpoints;
+    }
+#endif
+    store_cached(cache_filepath, endpoints);
+    return endpoints; // Workers return their partial results.
+  }
+
+  // Shades an endpoint buffer produced by render_endpoints against the current or the given background.
+  template <typename precision_type>
+  image_type                  shade               (const endpoint_buffer<precision_type>& endpoints) const
+  {
+    return shade(endpoints, background_data(), background_size());
+  }
+  template <typename precision_type>
+  image_type                  shade               (const endpoint_buffer<precision_type>& endpoints, const image_type& background) const
+  {
+    if constexpr (shared_device == shared_device_type::cuda)
+    {
+      const thrust::device_vector<pixel_type> device_background(background.data);
+      return shade(endpoints, device_background.data().get(), background.size);
+    }
+    else
+      return shade(endpoints, background.data.data(), background.size);
+  }
+
+  // Hashes all parameters which affect the rendered frame: the types and the parameters of the metric and the motion,
+  // the observer, the image size and, unless excluded (e.g. for endpoints, which do not depend on it), the background
+  // along with the cubemap and the anti-aliasing. The hash identifies a frame across runs of the same build.
+  std::uint64_t               scene_hash          (const bool include_background = true) const
+  {
+    hasher hasher;
+    hasher.add(std::uint32_t(1)); // The version of the hashed parameters.
+    hasher.add(typeid(metric_type).name());
+    hasher.add(typeid(motion_type).name());
+    hasher.add(metric_          );
+    hasher.add(iterations_      );
+    hasher.add(lambda_step_size_);
+    hasher.add(lambda_          );
+    hasher.add(bounds_          );
+    hasher.add(error_evaluator_ );
+    hasher.add(debug_           );
+
+    const auto& transform = observer_.get_transform();
+    hasher.add(transform.translation.data(), sizeof(scalar_type) * 3);
+    hasher.add(transform.rotation.coeffs().data(), sizeof(scalar_type) * 4);
+    hasher.add(transform.scale.data(), sizeof(scalar_type) * 3);
+    hasher.add(observer_.get_coordinate_time());
+    hasher.add(observer_.get_projection());
+    hasher.add(partitioner_.domain_size().data(), sizeof(std::int32_t) * 2);
+
+    if (include_background)
+    {
+      hasher.add(anti_aliased_);
+      hasher.add(background_size().data(), sizeof(std::int32_t) * 2);
+      hasher.add(host_background_data(), static_cast<std::size_t>(background_size().prod()) * sizeof(pixel_type));
+      hasher.add(cubemap_ ? cubemap_->face_size() : 0);
+      if (cubemap_)
+        hasher.add(cubemap_->data().data(), cubemap_->data().size() * sizeof(pixel_type));
+    }
+    return hasher.value();
+  }
+
+  // Traces a low resolution version of the frame on this rank alone, and returns the number of integration steps of each
+  // ray (in row major order) as an estimate of the cost of the corresponding region of the frame.
+  std::vector<float>          estimate_costs      (const image_size_type& size)
+  {
+    observer_.set_ray_differentials(false);
+    auto& rays = observer_.generate_rays(size, size, image_size_type::Zero().eval());
+    upload_device_data(nullptr, size, image_size_type::Zero().eval());
+
+    thrust::device_vector<float> device_costs(rays.size());
+    thrust::for_each(
+      thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(0)          , rays.begin())),
+      thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(rays.size()), rays.end  ())),
+      [data = device_data_.data().get(), costs = device_costs.data().get()] __device__ (const auto& iteratee)
+      {
+        const auto  index = data->pixel_indices ? data->pixel_indices[thrust::get<0>(iteratee)] : thrust::get<0>(iteratee);
+        std::size_t steps = 0;
+        trace_ray(thrust::get<1>(iteratee), *data, data->observer_position, true, &steps);
+        costs[index] = static_cast<float>(steps);
+      });
+
+    std::vector<float> costs(device_costs.size());
+    thrust::copy(device_costs.begin(), device_costs.end(), costs.begin());
+    return costs;
+  }
+  // Partitions the frame among the ranks by the cost estimate of a low resolution pre-pass (whose longer side has the 
+  // given resolution), so that the ranks receive blocks of unequal size but roughly equal cost. The pre-pass is traced
+  // by rank 0 and its estimate is broadcast, hence all ranks arrive at the same partition even if their devices differ.
+  // Rebalance whenever the scene changes significantly, e.g. every few frames of a video. Collective.
+  void                        balance_load        (const std::int32_t resolution = 64)
+  {
+    const auto&           image_size = partitioner_.domain_size();
+    const image_size_type size       = (image_size.template cast<double>() * static_cast<double>(resolution) / static_cast<double>(image_size.maxCoeff()))
+      .array().ceil().template cast<std::int32_t>().max(1);
+    set_load_weights(communicator_.rank() == 0 ? estimate_costs(size) : std::vector<float>(), size);
+  }
+  // Partitions the frame among the ranks by the given cost weights, defined on a grid of the given size stretched over
+  // the frame (e.g. the steps of the previous frame). Empty weights restore the equal partitioning. Collective: the
+  // weights of rank 0 are broadcast, as the gathers rely on identical partitions on all ranks. The other ranks may pass
+  // empty weights.
+  void                        set_load_weights    (std::vector<float> weights, image_size_type weights_size)
+  {
+    wait_async();
+    require_finished_pipeline();
+#ifdef ASTRAY_USE_MPI
+    auto count = static_cast<std::int32_t>(weights.size());
+    communicator_.bcast(&count, 1, mpi::data_type(MPI_INT));
+    if (count > 0)
+    {
+      weights.resize(count);
+      communicator_.bcast(weights.data()     , count, mpi::data_type(MPI_FLOAT));
+      communicator_.bcast(weights_size.data(), 2    , mpi::data_type(MPI_INT  ));
+    }
+    else
+      weights.clear();
 #endif
+    partitioner_.set_weights(weights, weights_size);
+    set_image_size(partitioner_.domain_size()); // Reallocates the blocks.
   }
 
   const image_size_type&      get_image_size      () const
@@ -194,13 +901,20 @@ public:
   }
   void                        set_image_size      (const image_size_type&      value)
   {
+    wait_async();
+    require_finished_pipeline();
+    for (auto& buffer : async_buffers_)
+      buffer = async_buffer(); // Reallocated on the next asynchronous render.
+
     partitioner_.set_domain_size(value);
     
-    result_             = image_type(partitioner_.block_size(), pixel_type());
-    device_result_      = result_.data;
+    // The frame buffers are allocated on the first render_frame, hence never by tiled rendering.
+    result_             = image_type(image_size_type::Zero().eval());
+    device_result_      .clear();
+    device_result_      .shrink_to_fit();
 
 #ifdef ASTRAY_USE_MPI
-    gathered_result_    = image_type(partitioner_.domain_size());
+    gathered_result_    = image_type(image_size_type::Zero().eval());
 
     pixel_data_type_    = mpi::data_type(mpi::data_type(MPI_UNSIGNED_CHAR), 3);
     subarray_data_type_ = mpi::data_type(pixel_data_type_   , value, partitioner_.block_size(), image_size_type::Zero().eval(), true);
@@ -226,14 +940,87 @@ public:
     observer_ = value;
   }
 
+  // Empty if the background is memory mapped or shared.
   const image_type&           get_background      () const
   {
     return background_;
   }
+  // Setting the background discards the cubemap. Under MPI, this is collective: the background of rank 0 is placed in
+  // memory shared by the ranks of each node (see mpi::share), hence a node holds a single copy regardless of its number
+  // of ranks, and the other ranks may pass an empty image instead of loading it.
   void                        set_background      (const image_type&           value)
   {
-    background_        = value;
-    device_background_ = background_.data;
+    wait_async();
+    mapped_background_.reset();
+#ifdef ASTRAY_USE_MPI
+    shared_background_size_ = value.size;
+    communicator_.bcast(shared_background_size_.data(), 2, mpi::data_type(MPI_INT));
+    background_             = image_type(image_size_type::Zero().eval());
+    shared_background_.emplace(mpi::share(communicator_, value.data.data(), static_cast<std::size_t>(shared_background_size_.prod())));
+#else
+    background_             = value;
+#endif
+    set_cubemap(std::nullopt);
+    if constexpr (shared_device == shared_device_type::cuda)
+    {
+      device_background_.resize(background_size().prod()); // Host device systems use the background in place.
+      thrust::copy_n(host_background_data(), background_size().prod(), device_background_.begin());
+    }
+    update_mip_pyramid();
+  }
+  // Host device systems sample the memory mapped background in place, without copying it. Under MPI, this is collective
+  // like the other overload, as it frees the shared window of a previous background (a collective over each node). Each
+  // rank maps the background itself.
+  void                        set_background      (mapped_image_type&&         value)
+  {
+    wait_async();
+    background_        = image_type(image_size_type::Zero().eval());
+    shared_background_.reset();
+    mapped_background_.emplace(std::move(value));
+    set_cubemap(std::nullopt);
+    if constexpr (shared_device == shared_device_type::cuda)
+    {
+      device_background_.resize(mapped_background_->size.prod()); // Uploaded straight from the mapping.
+      thrust::copy_n(mapped_background_->data(), mapped_background_->size.prod(), device_background_.begin());
+    }
+    update_mip_pyramid();
+  }
+
+  // If set, render_frame, render_frames and render_frame_async shade escaped rays from the cubemap, skipping the spherical
+  // conversion and the equirectangular lookup. render_endpoints and shade always use the equirectangular background.
+  const std::optional<cubemap_type>& get_cubemap  () const
+  {
+    return cubemap_;
+  }
+  void                        set_cubemap         (std::optional<cubemap_type>  value)
+  {
+    cubemap_ = std::move(value);
+    if constexpr (shared_device == shared_device_type::cuda)
+    {
+      if (cubemap_)
+        device_cubemap_ = cubemap_->data();
+      else
+        device_cubemap_.clear();
+    }
+  }
+  // Resamples the current background into a cubemap (see cubemap for the default face size).
+  void                        build_cubemap       (const std::int32_t          face_size = 0)
+  {
+    set_cubemap(cubemap_type(host_background_data(), background_size(), face_size));
+  }
+
+  // If set, rays carry differentials with respect to the pixel coordinates, propagated along the geodesic (see
+  // geodesic::integrate). The angular footprint of each pixel at the exit selects the level of a pre-filtered pyramid of 
+  // the background, anti-aliasing minified regions with a single geodesic per pixel, at about three times the cost of
+  // the integration. Not applied while a cubemap is set, nor by render_endpoints.
+  bool                        is_anti_aliased     () const
+  {
+    return anti_aliased_;
+  }
+  void                        set_anti_aliased    (const bool                  value)
+  {
+    anti_aliased_ = value;
+    update_mip_pyramid();
   }
 
         metric_type&          get_metric          ()
@@ -311,14 +1098,890 @@ public:
     debug_ = value;
   }
 
+  // If set, the blocks are run length coded before they are sent to rank 0 (see run_length), which reduces the bytes on
+  // the interconnect for large frames and high rank counts at the cost of encoding on the ranks and decoding on rank 0.
+  // Applies to the frames, tiles, regions and endpoints of the blocking gathers. The pipelined gathers, which are not
+  // allowed to wait for the compressed sizes, remain uncompressed.
+  bool                        is_gather_compressed() const
+  {
+    return gather_compressed_;
+  }
+  void                        set_gather_compressed(const bool                 value)
+  {
+    gather_compressed_ = value;
+  }
+
+  // If set, the frame is composited in two levels: the ranks of each node receive adjacent bands of the frame (see
+  // weighted_partitioner::set_nodes), and write their blocks into a stripe in memory shared by the node, which the leader
+  // of the node sends to rank 0 as a single contiguous message. Hence rank 0 receives one message per node instead of
+  // one per rank. Applies to the blocking gathers of frames and endpoints, in place of the compression. Collective.
+  bool                        is_node_aware       () const
+  {
+    return partitioner_.node_aware();
+  }
+  void                        set_node_aware      (const bool                  value)
+  {
+    wait_async();
+    require_finished_pipeline();
+    std::vector<std::int32_t> nodes(value ? communicator_.size() : 0, 0);
+#ifdef ASTRAY_USE_MPI
+    node_window_.reset();
+    if (value)
+    {
+      // The nodes are numbered by the ranks of their leaders among the leaders.
+      leader_communicator_ = communicator_.split(node_communicator_.rank() == 0 ? 0 : mpi::undefined, communicator_.rank());
+
+      const mpi::data_type index_data_type(MPI_INT);
+      std::int32_t         node = node_communicator_.rank() == 0 ? leader_communicator_.rank() : 0;
+      node_communicator_.bcast (&node, 1, index_data_type);
+      communicator_     .gather(&node, 1, index_data_type, nodes.data(), 1, index_data_type);
+      communicator_     .bcast (nodes.data(), communicator_.size(), index_data_type);
+    }
+#endif
+    partitioner_.set_nodes(nodes);
+    set_image_size(partitioner_.domain_size()); // Reallocates the blocks.
+  }
+
+  // The threads of OpenMP device systems. Unless a thread count is set, each rank runs its share of the processors
+  // available to it (see threading::processors), hence the ranks on a node do not oversubscribe it. The default affinity
+  // leaves the pinning to the environment (e.g. OMP_PROC_BIND or the launcher). While the threads are pinned, the frame
+  // buffers are first touched by the threads which shade them (see threading::first_touch), the rays are first touched
+  // by the parallel initialization of the device system anyway.
+  thread_affinity             get_thread_affinity () const
+  {
+    return thread_affinity_;
+  }
+  void                        set_thread_affinity (const thread_affinity       value)
+  {
+    thread_affinity_ = value;
+    update_threads();
+  }
+  std::int32_t                get_thread_count    () const
+  {
+    return thread_count_;
+  }
+  // Zero derives the thread count from the number of ranks on the node.
+  void                        set_thread_count    (const std::int32_t          value)
+  {
+    thread_count_ = value;
+    update_threads();
+  }
+
+  const std::optional<std::filesystem::path>& get_render_cache() const
+  {
+    return render_cache_;
+  }
+  // Sets the directory of the render cache, which serves render_frame and render_endpoints from disk if they were
+  // produced for the same scene before (see scene_hash). Frames are cached losslessly as QOI, endpoints as endpoint
+  // buffers. The cache is accessed on rank 0 only, and the other ranks skip rendering on a hit, hence their partial
+  // results are not updated (workers receive empty endpoints). Must be set equally on all ranks.
+  void                        set_render_cache    (const std::optional<std::filesystem::path>& value)
+  {
+    render_cache_ = value;
+    if (render_cache_ && communicator_.rank() == 0)
+      std::filesystem::create_directories(*render_cache_);
+  }
+
+  std::size_t                 get_async_buffer_count() const
+  {
+    return async_buffers_.size();
+  }
+  // At least two buffers are necessary to overlap the copy and the gather of a frame with the tracing of the next. The
+  // images of previously returned futures are invalidated.
+  void                        set_async_buffer_count(const std::size_t     value)
+  {
+    if (value == 0)
+      throw std::runtime_error("At least one async buffer is required.");
+
+    wait_async();
+    async_buffers_.resize(value);
+    async_index_ = 0;
+  }
+
   const mpi::communicator&    get_communicator    () const
   {
     return communicator_;
   }
   
 protected:
+  // A frame of pipelined rendering: the block of this rank and its gather in flight, with the partition it was started
+  // with. The request is declared last, hence it is completed before the buffers are destroyed.
+  struct pipeline_stage
+  {
+    image_type                   block        {image_size_type::Zero().eval()};
+    image_type                   gathered     {image_size_type::Zero().eval()};
+    std::vector<pixel_type>      blocks       ; // The contiguously gathered blocks of non-uniform partitions.
+    std::vector<std::int32_t>    counts       ; // Have to remain valid until the gather is complete.
+    std::vector<std::int32_t>    displacements;
+    std::vector<image_size_type> block_offsets;
+    std::vector<image_size_type> block_sizes  ;
+    bool                         uniform      = true;
+    bool                         started      = false;
+    mpi::request                 request      ;
+  };
+
+  // The buffers of tiled rendering, reused across tiles of equal size.
+  struct tile_buffer
+  {
+    image_type                        block       {image_size_type::Zero().eval()};
+    thrust::device_vector<pixel_type> device_block;
+    image_type                        tile        {image_size_type::Zero().eval()};
+  };
+
+  void                        update_threads      ()
+  {
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_OMP
+    threading::configure(thread_affinity_, node_communicator_.rank(), node_communicator_.size(), thread_count_);
+#endif
+  }
+  // Allocates a buffer which the device system shades into, first touched by the threads which shade it if they are
+  // pinned.
+  image_type                  make_result         (const image_size_type& size) const
+  {
+    image_type result(size, pixel_type());
+    if constexpr (shared_device != shared_device_type::cuda)
+      if (thread_affinity_ != thread_affinity::none)
+        threading::first_touch(result.data.data(), result.data.size(), pixel_type());
+    return result;
+  }
+
+  // The file of the render cache addressed by the key, which is computed on rank 0 only. Empty if there is no cache, and
+  // on workers.
+  template <typename key_function_type>
+  std::filesystem::path       render_cache_filepath(const char* extension, key_function_type&& key_function) const
+  {
+    if (!render_cache_ || communicator_.rank() != 0)
+      return {};
+
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key_function()));
+    return *render_cache_ / (std::string(name) + extension);
+  }
+  // Collective if there is a cache. Loads the cached result into the target on rank 0, and returns whether it was found
+  // on all ranks. Unreadable or mismatching entries are treated as missing (leaving the target as is) and are overwritten.
+  template <typename type>
+  bool                        load_cached         (const std::filesystem::path& filepath, type& target)
+  {
+    if (!render_cache_)
+      return false;
+
+    std::int32_t hit = 0;
+    if (!filepath.empty() && exists(filepath))
+    {
+      try
+      {
+        type cached(image_size_type::Zero().eval());
+        cached.load(filepath);
+        if (cached.size == partitioner_.domain_size())
+        {
+          target = std::move(cached);
+          hit    = 1;
+        }
+      }
+      catch (const std::exception&)
+      {
+        hit = 0;
+      }
+    }
+#ifdef ASTRAY_USE_MPI
+    communicator_.bcast(&hit, 1, mpi::data_type(MPI_INT));
+#endif
+    return hit != 0;
+  }
+  // Written under a temporary name and renamed, so that concurrent processes never read a partial entry.
+  template <typename type>
+  void                        store_cached        (const std::filesystem::path& filepath, const type& value) const
+  {
+    if (filepath.empty())
+      return;
+
+    auto temporary_filepath = filepath;
+    temporary_filepath.replace_extension(".tmp" + std::to_string(std::random_device()()) + filepath.extension().string());
+    value.save(temporary_filepath);
+    std::filesystem::rename(temporary_filepath, filepath);
+  }
+
+  // Renders a block of the image on this rank alone, into the block of the buffer.
+  image_type&                 render_local_block  (const image_size_type& size, const image_size_type& offset, tile_buffer& buffer)
+  {
+    auto& block = buffer.block;
+    if (block.size != size)
+    {
+      block                 = make_result(size);
+      if constexpr (shared_device == shared_device_type::cuda)
+        buffer.device_block = block.data;
+    }
+
+    if constexpr (shared_device == shared_device_type::cuda)
+    {
+      render_block(buffer.device_block.data().get(), size, offset);
+      thrust::copy(buffer.device_block.begin(), buffer.device_block.end(), block.data.begin());
+    }
+    else
+      render_block(block.data.data(), size, offset);
+    return block;
+  }
+  // Partitions a tile of the image among the ranks so that the blocks cover it exactly: equally if its size is divisible
+  // by the grid of the ranks, otherwise by bisection of unit costs, as the equal blocks would miss the remainder.
+  partitioner_type            make_tile_partitioner(const image_size_type& size) const
+  {
+    return make_tile_partitioner(size, communicator_.rank(), communicator_.size());
+  }
+  static partitioner_type     make_tile_partitioner(const image_size_type& size, const std::int32_t rank, const std::int32_t count)
+  {
+    partitioner_type result(rank, count, size);
+    if ((result.block_size().array() * result.grid_size().array() != size.array()).any())
+      result.set_weights({1.0f}, image_size_type(1, 1));
+    return result;
+  }
+  // Renders a tile of the image, partitioned across the ranks. Returns the tile on rank 0, nullptr on workers.
+  const image_type*           render_tile         (const image_size_type& size, const image_size_type& offset, tile_buffer& buffer)
+  {
+    const auto tile_partitioner = make_tile_partitioner(size);
+
+    auto& block = render_local_block(tile_partitioner.block_size(), offset + tile_partitioner.rank_offset(), buffer);
+
+#ifdef ASTRAY_USE_MPI
+    if (communicator_.rank() == 0 && buffer.tile.size != size)
+      buffer.tile = image_type(size, pixel_type());
+
+    // The subarray is only used by equal partitions, the blocks of bisected ones may be empty.
+    const image_size_type block_size = tile_partitioner.block_size().cwiseMax(1);
+    const mpi::data_type  subarray_data_type(pixel_data_type_   , size, block_size, image_size_type::Zero().eval(), true);
+    const mpi::data_type  resized_data_type (subarray_data_type, 0   , block_size[0] * sizeof(pixel_type));
+    gather(block.data.data(), communicator_.rank() == 0 ? buffer.tile.data.data() : nullptr, pixel_data_type_, resized_data_type, tile_partitioner);
+
+    return communicator_.rank() == 0 ? &buffer.tile : nullptr;
+#else
+    return &block;
+#endif
+  }
+
+  // Traces an arbitrary block of the image on this rank alone, storing the endpoint of each ray.
+  template <typename precision_type>
+  endpoint_buffer<precision_type> trace_endpoints (const image_size_type& size, const image_size_type& offset)
+  {
+    using endpoint_type = endpoint<precision_type>;
+
+    auto& rays = prepare_rays(nullptr, size, offset, false);
+
+    endpoint_buffer<precision_type>      endpoints(size);
+    thrust::device_vector<endpoint_type> device_endpoints;
+    endpoint_type*                       target = endpoints.data.data(); // Host device systems write straight into the buffer.
+    if constexpr (shared_device == shared_device_type::cuda)
+    {
+      device_endpoints.resize(rays.size());
+      target = device_endpoints.data().get();
+    }
+
+    thrust::for_each(
+      thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(0)          , rays.begin())),
+      thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(rays.size()), rays.end  ())),
+      [data = device_data_.data().get(), endpoints = target] __device__ (const auto& iteratee)
+      {
+        const auto index       = data->pixel_indices ? data->pixel_indices[thrust::get<0>(iteratee)] : thrust::get<0>(iteratee);
+        auto&      ray         = thrust::get<1>(iteratee);
+        const auto termination = trace_ray(ray, *data, data->observer_position);
+        const auto escaped     = termination == termination_reason::none || termination == termination_reason::out_of_bounds;
+
+        auto& endpoint         = endpoints[index];
+        endpoint.theta         = static_cast<precision_type>(escaped ? ray.position[2] : static_cast<scalar_type>(0));
+        endpoint.phi           = static_cast<precision_type>(escaped ? ray.position[3] : static_cast<scalar_type>(0));
+        endpoint.termination   = termination;
+      });
+
+    if constexpr (shared_device == shared_device_type::cuda)
+      thrust::copy(device_endpoints.begin(), device_endpoints.end(), endpoints.data.begin());
+    return endpoints;
+  }
+  // Traces the endpoints of a tile of the image, partitioned across the ranks. Returns the tile on rank 0, an empty
+  // buffer on workers.
+  template <typename precision_type>
+  endpoint_buffer<precision_type> render_tile_endpoints(const image_size_type& size, const image_size_type& offset)
+  {
+    const auto tile_partitioner = make_tile_partitioner(size);
+
+    auto block = trace_endpoints<precision_type>(tile_partitioner.block_size(), offset + tile_partitioner.rank_offset());
+
+#ifdef ASTRAY_USE_MPI
+    using endpoint_type = endpoint<precision_type>;
+
+    const image_size_type block_size = tile_partitioner.block_size().cwiseMax(1); // See render_tile.
+    const mpi::data_type  endpoint_data_type(mpi::data_type(MPI_BYTE), static_cast<std::int32_t>(sizeof(endpoint_type)));
+    const mpi::data_type  subarray_data_type(endpoint_data_type, size, block_size, image_size_type::Zero().eval(), true);
+    const mpi::data_type  resized_data_type (subarray_data_type, 0   , block_size[0] * sizeof(endpoint_type));
+
+    endpoint_buffer<precision_type> tile(communicator_.rank() == 0 ? size : image_size_type::Zero().eval());
+    gather(block.data.data(), communicator_.rank() == 0 ? tile.data.data() : nullptr, endpoint_data_type, resized_data_type, tile_partitioner);
+    return tile;
+#else
+    return block;
+#endif
+  }
+
+  // Traces and shades the block of this rank into the given (device) result.
+  void                        render_block        (pixel_type* result)
+  {
+    render_block(result, partitioner_.block_size(), partitioner_.rank_offset());
+  }
+  // Traces and shades an arbitrary block of the image into the given (device) result.
+  void                        render_block        (pixel_type* result, const image_size_type& block_size, const image_size_type& block_offset)
+  {
+    auto& rays = prepare_rays(result, block_size, block_offset);
+
+    thrust::for_each(
+      thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(0)          , rays.begin())),
+      thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<std::size_t>(rays.size()), rays.end  ())),
+      [data = device_data_.data().get()] __device__ (const auto& iteratee)
+      {
+        const auto index = data->pixel_indices ? data->pixel_indices[thrust::get<0>(iteratee)] : thrust::get<0>(iteratee);
+        render_pixel(thrust::get<1>(iteratee), thrust::get<0>(iteratee), *data, data->observer_position, data->result[index]);
+      });
+  }
+
+  // Generates the rays of the block of this rank (with differentials if the rays are shaded with anti-aliasing) and
+  // uploads the frame constants to the device.
+  thrust::device_vector<ray_type>& prepare_rays(pixel_type* result, const bool shaded = true)
+  {
+    return prepare_rays(result, partitioner_.block_size(), partitioner_.rank_offset(), shaded);
+  }
+  thrust::device_vector<ray_type>& prepare_rays(pixel_type* result, const image_size_type& block_size, const image_size_type& block_offset, const bool shaded = true)
+  {
+    observer_.set_ray_differentials(shaded && ray_differentials());
+    auto& rays = observer_.generate_rays(partitioner_.domain_size(), block_size, block_offset);
+    upload_device_data(result, block_size, block_offset);
+    return rays;
+  }
+  void                        upload_device_data  (pixel_type* result)
+  {
+    upload_device_data(result, partitioner_.block_size(), partitioner_.rank_offset());
+  }
+  void                        upload_device_data  (pixel_type* result, const image_size_type& block_size, const image_size_type& block_offset)
+  {
+    const auto  cubemap_face_size = cubemap_     ? cubemap_    ->face_size  () : 0;
+    const auto  mip_level_count   = mip_pyramid_ ? mip_pyramid_->level_count() : 0;
+    device_data data 
+    {
+      vector_type(
+        observer_.get_coordinate_time(), 
+        observer_.get_transform().translation[0], 
+        observer_.get_transform().translation[1], 
+        observer_.get_transform().translation[2]),
+      background_data()              ,
+      background_size()              ,
+      cubemap_data()                 ,
+      cubemap_face_size              ,
+      mip_pyramid_data()             ,
+      mip_level_count                ,
+      metric_                        ,
+      iterations_                    ,
+      lambda_step_size_              ,
+      lambda_                        ,
+      bounds_                        ,
+      //error_evaluator              ,
+      debug_                         ,
+      result                         ,
+      block_size                     ,
+      block_offset                   ,
+      // Rays may be generated in a space-filling curve order, the results are scattered back to row major order.
+      observer_.get_pixel_indices().empty() ? nullptr : observer_.get_pixel_indices().data().get(),
+      observer_.get_differentials().empty() ? nullptr : observer_.get_differentials().data().get()
+    };
+    thrust::copy_n(&data, 1, device_data_.begin());
+  }
+
+  void                        allocate_results    ()
+  {
+    if (result_.size == partitioner_.block_size())
+      return;
+
+    result_             = make_result(partitioner_.block_size());
+    if constexpr (shared_device == shared_device_type::cuda)
+      device_result_    = result_.data;
+#ifdef ASTRAY_USE_MPI
+    gathered_result_    = image_type(partitioner_.domain_size());
+#endif
+  }
+
+  const pixel_type*           background_data     () const
+  {
+    if constexpr (shared_device == shared_device_type::cuda)
+      return device_background_.data().get();
+    else
+      return host_background_data();
+  }
+  const image_size_type&      background_size     () const
+  {
+    if (mapped_background_)
+      return mapped_background_->size;
+    return shared_background_ ? shared_background_size_ : background_.size;
+  }
+  const pixel_type*           host_background_data() const
+  {
+    if (mapped_background_)
+      return mapped_background_->data();
+    return shared_background_ ? shared_background_->data() : background_.data.data();
+  }
+  const pixel_type*           cubemap_data        () const
+  {
+    if (!cubemap_)
+      return nullptr;
+    if constexpr (shared_device == shared_device_type::cuda)
+      return device_cubemap_.data().get();
+    else
+      return cubemap_->data().data();
+  }
+
+  const pixel_type*           mip_pyramid_data    () const
+  {
+    if (!mip_pyramid_)
+      return nullptr;
+    if constexpr (shared_device == shared_device_type::cuda)
+      return device_mip_pyramid_.data().get();
+    else
+      return mip_pyramid_->data().data();
+  }
+  // The pyramid is built from the background while anti-aliasing is enabled.
+  void                        update_mip_pyramid  ()
+  {
+    if (anti_aliased_ && background_size().prod() > 0)
+      mip_pyramid_.emplace(host_background_data(), background_size());
+    else
+      mip_pyramid_.reset();
+
+    if constexpr (shared_device == shared_device_type::cuda)
+    {
+      if (mip_pyramid_)
+        device_mip_pyramid_ = mip_pyramid_->data();
+      else
+        device_mip_pyramid_.clear();
+    }
+  }
+  bool                        ray_differentials   () const
+  {
+    return anti_aliased_ && !cubemap_;
+  }
+
+  template <typename precision_type>
+  image_type                  shade               (const endpoint_buffer<precision_type>& endpoints, const pixel_type* background, const image_size_type& background_size) const
+  {
+    using endpoint_type = endpoint<precision_type>;
+
+    image_type                           result(endpoints.size, pixel_type());
+    const endpoint_type*                 source = endpoints.data.data(); // Host device systems read and write in place.
+    pixel_type*                          target = result   .data.data();
+    thrust::device_vector<endpoint_type> device_endpoints;
+    thrust::device_vector<pixel_type>    device_result   ;
+    if constexpr (shared_device == shared_device_type::cuda)
+    {
+      device_endpoints = endpoints.data;
+      device_result    = result   .data;
+      source           = device_endpoints.data().get();
+      target           = device_result   .data().get();
+    }
+
+    thrust::for_each(
+      thrust::device,
+      thrust::counting_iterator<std::size_t>(0),
+      thrust::counting_iterator<std::size_t>(endpoints.data.size()),
+      [source, target, background, background_size, debug = debug_] __device__ (const std::size_t index)
+      {
+        const auto& endpoint = source[index];
+        shade_pixel(endpoint.termination, static_cast<scalar_type>(endpoint.theta), static_cast<scalar_type>(endpoint.phi), background, background_size, debug, target[index]);
+      });
+
+    if constexpr (shared_device == shared_device_type::cuda)
+      thrust::copy(device_result.begin(), device_result.end(), result.data.begin());
+    return result;
+  }
+
+  // Integrates the ray through the metric. If the ray escapes, its position is converted to the spherical coordinates of
+  // the exit point relative to the observer, whose angles index the environment map (or left in cartesian coordinates, 
+  // whose direction indexes the cubemap).
+  __device__ static termination_reason trace_ray  (ray_type& ray, const device_data& data, const vector_type& observer_position, const bool spherical = true, std::size_t* steps = nullptr)
+  {
+    metric_type metric(data.metric); // A copy is necessary for correct creation of virtual function table.
+        
+    if constexpr (metric_type::coordinate_system() == coordinate_system_type::boyer_lindquist || metric_type::coordinate_system() == coordinate_system_type::prolate_spheroidal)
+      convert_ray<coordinate_system_type::cartesian, metric_type::coordinate_system()>(ray, metric.coordinate_system_parameter());
+    else
+      convert_ray<coordinate_system_type::cartesian, metric_type::coordinate_system()>(ray);
+        
+    const auto termination = motion_type::integrate(ray, metric, data.iterations, data.lambda_step_size, data.lambda, data.bounds, error_evaluator_type() /*data.error_evaluator*/, steps);
+        
+    if (termination == termination_reason::none || termination == termination_reason::out_of_bounds)
+    {
+      if constexpr (metric_type::coordinate_system() == coordinate_system_type::boyer_lindquist || metric_type::coordinate_system() == coordinate_system_type::prolate_spheroidal)
+        convert<metric_type::coordinate_system(), coordinate_system_type::cartesian>(ray.position, metric.coordinate_system_parameter());
+      else
+        convert<metric_type::coordinate_system(), coordinate_system_type::cartesian>(ray.position);
+        
+      ray.position -= observer_position; // Environment map is relative to observer.
+          
+      if (spherical)
+        convert<coordinate_system_type::cartesian, coordinate_system_type::spherical>(ray.position);
+    }
+
+    return termination;
+  }
+  // Traces the ray like trace_ray along with its differentials, and computes the angular footprint of the pixel at the 
+  // exit point as seen from the observer, i.e. the angle between the exit points of neighboring pixels.
+  __device__ static termination_reason trace_ray  (ray_type& ray, differentials_type& differentials, const device_data& data, const vector_type& observer_position, scalar_type& footprint)
+  {
+    metric_type metric(data.metric); // A copy is necessary for correct creation of virtual function table.
+
+    const auto to_metric    = [&metric] (ray_type& value)
+    {
+      if constexpr (metric_type::coordinate_system() == coordinate_system_type::boyer_lindquist || metric_type::coordinate_system() == coordinate_system_type::prolate_spheroidal)
+        convert_ray<coordinate_system_type::cartesian, metric_type::coordinate_system()>(value, metric.coordinate_system_parameter());
+      else
+        convert_ray<coordinate_system_type::cartesian, metric_type::coordinate_system()>(value);
+    };
+    const auto to_cartesian = [&metric] (ray_type& value)
+    {
+      if constexpr (metric_type::coordinate_system() == coordinate_system_type::boyer_lindquist || metric_type::coordinate_system() == coordinate_system_type::prolate_spheroidal)
+        convert<metric_type::coordinate_system(), coordinate_system_type::cartesian>(value.position, metric.coordinate_system_parameter());
+      else
+        convert<metric_type::coordinate_system(), coordinate_system_type::cartesian>(value.position);
+    };
+
+    auto source = ray;
+    to_metric(ray);
+    convert_differentials(source, ray, differentials, to_metric);
+
+    const auto termination = motion_type::integrate(ray, differentials, metric, data.iterations, data.lambda_step_size, data.lambda, data.bounds);
+
+    footprint = static_cast<scalar_type>(0);
+    if (termination == termination_reason::none || termination == termination_reason::out_of_bounds)
+    {
+      source = ray;
+      to_cartesian(ray);
+      convert_differentials(source, ray, differentials, to_cartesian);
+
+      ray.position -= observer_position; // Environment map is relative to observer.
+
+      const auto distance  = ray.position.template tail<3>().norm();
+      const auto direction = (ray.position.template tail<3>() / distance).eval();
+      for (auto i = 0; i < 2; ++i)
+      {
+        const auto differential = differentials.position[i].template tail<3>().eval();
+        footprint = std::max(footprint, (differential - direction * direction.dot(differential)).norm() / distance);
+      }
+
+      convert<coordinate_system_type::cartesian, coordinate_system_type::spherical>(ray.position);
+    }
+
+    return termination;
+  }
+  // Converts the differentials of the source ray to those of the converted target ray, by forward differences of the 
+  // conversion. Differences of periodic coordinates are unwrapped.
+  template <typename conversion_type>
+  __device__ static void               convert_differentials(const ray_type& source, const ray_type& target, differentials_type& differentials, const conversion_type& conversion)
+  {
+    using constants = constants<scalar_type>;
+
+    for (auto i = 0; i < 2; ++i)
+    {
+      const auto length = std::sqrt(differentials.position[i].squaredNorm() + differentials.direction[i].squaredNorm());
+      if (!(length > static_cast<scalar_type>(0)))
+        continue;
+
+      const auto scale  = std::sqrt(std::numeric_limits<scalar_type>::epsilon()) * (static_cast<scalar_type>(1) + source.position.norm()) / length;
+      ray_type   shifted {source.position + scale * differentials.position[i], source.direction + scale * differentials.direction[i]};
+      conversion(shifted);
+
+      vector_type position_difference = shifted.position - target.position;
+      for (auto j = 0; j < 4; ++j)
+        if (std::abs(position_difference[j]) > constants::pi)
+          position_difference[j] -= std::copysign(constants::two_pi, position_difference[j]);
+
+      differentials.position [i] = position_difference                  / scale;
+      differentials.direction[i] = (shifted.direction - target.direction) / scale;
+    }
+  }
+  // Traces and shades the ray of a pixel, anti-aliased if the ray has differentials.
+  __device__ static void               render_pixel(ray_type& ray, const std::size_t ray_index, const device_data& data, const vector_type& observer_position, pixel_type& result)
+  {
+    if (data.differentials && data.mip_pyramid)
+    {
+      scalar_type footprint;
+      const auto  termination = trace_ray(ray, data.differentials[ray_index], data, observer_position, footprint);
+      if (termination == termination_reason::none || termination == termination_reason::out_of_bounds)
+      {
+        // The texels of level 0 span pi / height radians in theta, each level doubles that.
+        const auto level = std::log2(footprint * static_cast<scalar_type>(data.background_size[1]) / constants<scalar_type>::pi);
+        result = mip_pyramid_type::sample(data.mip_pyramid, data.background_size, data.mip_level_count, ray.position[2], ray.position[3], level);
+      }
+      else
+        result = pixel_type(0, 0, 0);
+      shade_debug(termination, data.debug, result);
+      return;
+    }
+
+    const auto termination = trace_ray(ray, data, observer_position, !data.cubemap);
+    shade_pixel(termination, ray, data, result);
+  }
+  // Shades a ray traced by trace_ray, from the cubemap if there is one.
+  __device__ static void               shade_pixel(const termination_reason termination, const ray_type& ray, const device_data& data, pixel_type& result)
+  {
+    if (!data.cubemap)
+    {
+      shade_pixel(termination, ray.position[2], ray.position[3], data.background, data.background_size, data.debug, result);
+      return;
+    }
+
+    if (termination == termination_reason::none || termination == termination_reason::out_of_bounds)
+      result = cubemap_type::sample(data.cubemap, data.cubemap_face_size, ray.position[1], ray.position[2], ray.position[3]);
+    else
+      result = pixel_type(0, 0, 0);
+    shade_debug(termination, data.debug, result);
+  }
+  // Samples the environment map in the exit direction of escaped rays, and applies the debug colors to the others.
+  __device__ static void               shade_pixel(
+    const termination_reason termination    , 
+    const scalar_type        theta          , 
+    const scalar_type        phi            , 
+    const pixel_type*        background     , 
+    const image_size_type&   background_size, 
+    const bool               debug          , 
+    pixel_type&              result         )
+  {
+    using constants = constants<scalar_type>;
+
+    if (termination == termination_reason::none || termination == termination_reason::out_of_bounds)
+    {
+      image_size_type background_index(
+        std::floor(phi   / constants::two_pi * static_cast<scalar_type>(background_size[0])),
+        std::floor(theta / constants::pi     * static_cast<scalar_type>(background_size[1])));
+      if (background_index[1] == background_size[1]) --background_index[1];
+          
+      result = background[ravel_multi_index<image_size_type, true>(background_index, background_size)];
+    }
+    else
+      result = pixel_type(0, 0, 0); // Results are reused across frames, hence captured rays are written explicitly.
+
+    shade_debug(termination, debug, result);
+  }
+  __device__ static void               shade_debug(const termination_reason termination, const bool debug, pixel_type& result)
+  {
+    if (debug)
+    {
+      if      (termination == termination_reason::constraint_violation)
+        result = pixel_type(255, 128, 128);
+      else if (termination == termination_reason::numeric_error       )
+        result = pixel_type(128, 255, 128);
+      else if (termination == termination_reason::spacetime_breakdown )
+        result = pixel_type(128, 128, 255);
+    }
+  }
+
+#ifdef ASTRAY_USE_MPI
+  // Gathers the blocks of all ranks into the complete domain on rank 0.
+  template <typename type>
+  void                        gather              (type* block, type* gathered, const mpi::data_type& data_type, const mpi::data_type& resized_data_type)
+  {
+    gather(block, gathered, data_type, resized_data_type, partitioner_);
+  }
+  // Gathers the blocks of all ranks into the complete domain of the given partitioner (e.g. of a tile) on rank 0.
+  template <typename type>
+  void                        gather              (type* block, type* gathered, const mpi::data_type& data_type, const mpi::data_type& resized_data_type, const partitioner_type& partitioner)
+  {
+    if (partitioner.node_aware())
+    {
+      gather_hierarchical(block, gathered, partitioner);
+      return;
+    }
+    if (gather_compressed_)
+    {
+      gather_compressed(block, gathered, partitioner);
+      return;
+    }
+
+    std::vector<std::int32_t> counts       ;
+    std::vector<std::int32_t> displacements;
+    gather_layout(partitioner, counts, displacements);
+
+    if (partitioner.uniform())
+    {
+      communicator_.gatherv(
+        block   , static_cast<std::int32_t>(partitioner.block_size().prod()), data_type        ,
+        gathered, counts.data(), displacements.data()                       , resized_data_type);
+      return;
+    }
+
+    std::vector<type> blocks(communicator_.rank() == 0 ? static_cast<std::size_t>(displacements.back() + counts.back()) : 0);
+    communicator_.gatherv(
+      block        , counts[communicator_.rank()]         , data_type,
+      blocks.data(), counts.data(), displacements.data(), data_type);
+    if (communicator_.rank() == 0)
+      rearrange(blocks.data(), gathered, displacements, partitioner);
+  }
+  // Assembles the bands of the ranks of each node in the shared stripe of the node, and gathers the stripes of the node
+  // leaders on rank 0. The stripes are contiguous in the domain, hence they are gathered in place.
+  template <typename type>
+  void                        gather_hierarchical (const type* block, type* gathered, const partitioner_type& partitioner)
+  {
+    const auto& nodes       = partitioner.nodes();
+    const auto& domain_size = partitioner.domain_size();
+    const auto  node_count  = static_cast<std::size_t>(*std::max_element(nodes.begin(), nodes.end()) + 1);
+
+    std::vector<std::int32_t> counts       (node_count, 0);
+    std::vector<std::int32_t> displacements(node_count, std::numeric_limits<std::int32_t>::max());
+    for (auto rank = 0; rank < communicator_.size(); ++rank)
+    {
+      counts       [nodes[rank]] += partitioner.block_sizes()[rank].prod();
+      displacements[nodes[rank]]  = std::min(displacements[nodes[rank]], partitioner.block_offsets()[rank][1] * domain_size[0]);
+    }
+
+    // The window is reallocated by all ranks of the node alike, as they share the stripe size.
+    const auto node       = nodes[communicator_.rank()];
+    const auto byte_count = static_cast<std::size_t>(counts[node]) * sizeof(type);
+    if (!node_window_ || node_window_->size() < byte_count)
+      node_window_.emplace(node_communicator_, byte_count);
+
+    auto* stripe = reinterpret_cast<type*>(node_window_->data());
+    node_window_->fence(); // The leader has sent the previous stripe.
+    std::copy_n(block, partitioner.block_size().prod(), stripe + (partitioner.rank_offset()[1] * domain_size[0] - displacements[node]));
+    node_window_->fence();
+
+    if (node_communicator_.rank() == 0)
+    {
+      const mpi::data_type element_data_type(mpi::data_type(MPI_BYTE), static_cast<std::int32_t>(sizeof(type)));
+      leader_communicator_.gatherv(
+        stripe  , counts[node]                        , element_data_type,
+        gathered, counts.data(), displacements.data(), element_data_type);
+    }
+  }
+  // Gathers the run length coded blocks contiguously after their sizes, and decodes and rearranges them on rank 0.
+  template <typename type>
+  void                        gather_compressed   (const type* block, type* gathered, const partitioner_type& partitioner)
+  {
+    const auto root    = communicator_.rank() == 0;
+    auto       encoded = run_length::encode(reinterpret_cast<const std::uint8_t*>(block), static_cast<std::size_t>(partitioner.block_size().prod()), sizeof(type));
+    auto       size    = static_cast<std::int32_t>(encoded.size());
+
+    const mpi::data_type      size_data_type(MPI_INT );
+    const mpi::data_type      byte_data_type(MPI_BYTE);
+    std::vector<std::int32_t> sizes         (root ? communicator_.size() : 0);
+    std::vector<std::int32_t> displacements (root ? communicator_.size() : 0, 0);
+    communicator_.gather(&size, 1, size_data_type, sizes.data(), 1, size_data_type);
+    for (std::size_t rank = 1; rank < sizes.size(); ++rank)
+      displacements[rank] = displacements[rank - 1] + sizes[rank - 1];
+
+    std::vector<std::uint8_t> received(root ? static_cast<std::size_t>(displacements.back() + sizes.back()) : 0);
+    communicator_.gatherv(
+      encoded .data(), size, byte_data_type,
+      received.data(), sizes.data(), displacements.data(), byte_data_type);
+    if (!root)
+      return;
+
+    std::vector<std::int32_t> block_displacements(communicator_.size(), 0);
+    for (auto rank = 1; rank < communicator_.size(); ++rank)
+      block_displacements[rank] = block_displacements[rank - 1] + partitioner.block_sizes()[rank - 1].prod();
+
+    std::vector<type> blocks(static_cast<std::size_t>(block_displacements.back() + partitioner.block_sizes().back().prod()));
+    for (auto rank = 0; rank < communicator_.size(); ++rank)
+      run_length::decode(
+        received.data() + displacements[rank], static_cast<std::size_t>(sizes[rank]), static_cast<std::size_t>(partitioner.block_sizes()[rank].prod()), sizeof(type),
+        reinterpret_cast<std::uint8_t*>(blocks.data() + block_displacements[rank]));
+    rearrange(blocks.data(), gathered, block_displacements, partitioner);
+  }
+  // Equal blocks are gathered in place through the resized subarray type, with the displacements in units of block rows.
+  // The blocks of weighted and node aware partitions differ in size, hence they are gathered contiguously and rearranged
+  // on rank 0.
+  void                        gather_layout       (const partitioner_type& partitioner, std::vector<std::int32_t>& counts, std::vector<std::int32_t>& displacements) const
+  {
+    counts       .assign(communicator_.size(), 1);
+    displacements.assign(communicator_.size(), 0);
+    if (partitioner.uniform())
+    {
+      for (auto y = 0; y < partitioner.grid_size()[1]; ++y)
+        for (auto x = 0; x < partitioner.grid_size()[0]; ++x)
+          displacements[x + y * partitioner.grid_size()[0]] = x + y * (partitioner.block_size()[1] * partitioner.grid_size()[0]);
+      return;
+    }
+
+    for (auto rank = 0; rank < communicator_.size(); ++rank)
+    {
+      counts[rank] = partitioner.block_sizes()[rank].prod();
+      if (rank > 0)
+        displacements[rank] = displacements[rank - 1] + counts[rank - 1];
+    }
+  }
+  template <typename type>
+  void                        rearrange           (const type* blocks, type* gathered, const std::vector<std::int32_t>& displacements, const partitioner_type& partitioner) const
+  {
+    rearrange(blocks, gathered, displacements, partitioner.block_offsets(), partitioner.block_sizes(), partitioner.domain_size());
+  }
+  template <typename type>
+  void                        rearrange           (const type* blocks, type* gathered, const std::vector<std::int32_t>& displacements, const std::vector<image_size_type>& block_offsets, const std::vector<image_size_type>& block_sizes, const image_size_type& domain_size) const
+  {
+    for (auto rank = 0; rank < communicator_.size(); ++rank)
+    {
+      const auto& offset = block_offsets[rank];
+      const auto& size   = block_sizes  [rank];
+      for (auto y = 0; y < size[1]; ++y)
+        std::copy_n(
+          blocks   + displacements[rank] + static_cast<std::size_t>(y) * size[0], size[0],
+          gathered + offset[0] + static_cast<std::size_t>(offset[1] + y) * domain_size[0]);
+    }
+  }
+
+  // Starts the gather of the block of the pipeline stage.
+  void                        start_gather        (pipeline_stage& stage)
+  {
+    gather_layout(partitioner_, stage.counts, stage.displacements);
+    stage.block_offsets = partitioner_.block_offsets();
+    stage.block_sizes   = partitioner_.block_sizes  ();
+    stage.uniform       = partitioner_.uniform      ();
+
+    const auto root = communicator_.rank() == 0;
+    if (root && stage.gathered.size != partitioner_.domain_size())
+      stage.gathered = image_type(partitioner_.domain_size());
+
+    if (partitioner_.uniform())
+      stage.request = communicator_.igatherv(
+        stage.block   .data.data(), static_cast<std::int32_t>(stage.block.data.size()), pixel_data_type_  ,
+        root ? stage.gathered.data.data() : nullptr, stage.counts.data(), stage.displacements.data(), resized_data_type_);
+    else
+    {
+      stage.blocks.resize(root ? stage.gathered.data.size() : 0);
+      stage.request = communicator_.igatherv(
+        stage.block .data.data(), static_cast<std::int32_t>(stage.block.data.size()), pixel_data_type_,
+        stage.blocks.data()     , stage.counts.data(), stage.displacements.data()   , pixel_data_type_);
+    }
+    stage.started = true;
+  }
+  // Completes the gather of the pipeline stage, and swaps the gathered frame into the target on rank 0.
+  bool                        complete_gather     (pipeline_stage& stage, image_type& target)
+  {
+    if (!stage.started)
+      return false;
+
+    stage.request.wait();
+    stage.started = false;
+    if (communicator_.rank() != 0)
+      return false;
+
+    if (!stage.uniform)
+      rearrange(stage.blocks.data(), stage.gathered.data.data(), stage.displacements, stage.block_offsets, stage.block_sizes, stage.gathered.size);
+    std::swap(target, stage.gathered);
+    return true;
+  }
+#endif
+  // The gathers in flight rely on the buffers and the data types of the current partition.
+  void                        require_finished_pipeline() const
+  {
+    for (auto& stage : pipeline_)
+      if (stage.started)
+        throw std::runtime_error("Finish the pipeline before changing the partition.");
+  }
+
   observer_type                      observer_          ;
   image_type                         background_        ;
+  std::optional<mapped_image_type>   mapped_background_ ;
+  std::optional<cubemap_type>        cubemap_           ;
+  std::optional<mip_pyramid_type>    mip_pyramid_       ;
                                      
   metric_type                        metric_            ;
   std::size_t                        iterations_        ;
@@ -327,18 +1990,34 @@ protected:
   bounds_type                        bounds_            ;
   error_evaluator_type               error_evaluator_   ;
   bool                               debug_             ;
+  bool                               anti_aliased_      = false;
+  bool                               gather_compressed_ = false;
+  thread_affinity                    thread_affinity_   = thread_affinity::none;
+  std::int32_t                       thread_count_      = 0;
+  std::optional<std::filesystem::path> render_cache_    ;
 
   thrust::device_vector<device_data> device_data_       {1};
   thrust::device_vector<pixel_type>  device_background_ ;
+  thrust::device_vector<pixel_type>  device_cubemap_    ;
+  thrust::device_vector<pixel_type>  device_mip_pyramid_;
   thrust::device_vector<pixel_type>  device_result_     ;
   image_type                         result_            ;
   image_type                         gathered_result_   ;
+  std::vector<async_buffer>          async_buffers_     {2};
+  std::size_t                        async_index_       = 0;
 
   mpi::environment                   environment_       ;
+  std::array<pipeline_stage, 2>      pipeline_          ; // Declared after the environment, hence completed before finalization.
+  std::size_t                        pipeline_index_    = 0;
   mpi::communicator                  communicator_      ;
   partitioner_type                   partitioner_       ;
   mpi::data_type                     pixel_data_type_   ;
   mpi::data_type                     subarray_data_type_;
   mpi::data_type                     resized_data_type_ ;
+  std::optional<shared_pixels_type>  shared_background_ ; // Declared after the environment, hence freed before finalization.
+  image_size_type                    shared_background_size_ {image_size_type::Zero().eval()};
+  mpi::communicator                  node_communicator_ ;
+  mpi::communicator                  leader_communicator_;
+  std::optional<shared_bytes_type>   node_window_       ;
 };
 }
\ No newline at end of file
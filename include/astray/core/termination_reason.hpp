@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
+
 namespace ast
 {
-enum class termination_reason
+enum class termination_reason : std::uint8_t
 {
   none                ,
   constraint_violation,
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#include <astray/core/endpoint_buffer.hpp>
+#include <astray/math/indexing.hpp>
+#include <astray/math/linear_algebra.hpp>
+#include <astray/media/image.hpp>
+#include <astray/utility/hash.hpp>
+
+namespace ast
+{
+// A file of the finished tiles of a frame (see ray_tracer::render_tiles_checkpointed), optionally with their endpoint
+// buffers. The tiles are appended as checksummed records after a header which identifies the scene by its hash, the
+// image size and the tile size. Opening an existing checkpoint restores its complete records and discards a record
+// which was torn by the termination of the process. A checkpoint of another scene is replaced.
+template <typename precision_type = float>
+class tile_checkpoint
+{
+public:
+  using pixel_type      = vector3<std::uint8_t>;
+  using image_type      = image<pixel_type>;
+  using size_type       = image_type::size_type;
+  using endpoint_type   = endpoint<precision_type>;
+  using endpoints_type  = endpoint_buffer<precision_type>;
+
+  struct header
+  {
+    char          magic        [8] = {'A', 'S', 'T', 'R', 'A', 'Y', 'C', 'P'};
+    std::uint32_t version          = 1;
+    std::uint32_t endpoint_size    = 0; // Zero if the records hold no endpoints.
+    std::uint64_t scene_hash       = 0;
+    std::int32_t  image_size   [2] = {0, 0};
+    std::int32_t  tile_size    [2] = {0, 0};
+  };
+  struct record
+  {
+    std::int32_t  tile             = 0;
+    std::uint32_t reserved         = 0;
+    std::uint64_t checksum         = 0; // Of the pixels and the endpoints.
+  };
+
+  explicit tile_checkpoint  (const std::filesystem::path& filepath, const std::uint64_t scene_hash, const size_type& image_size, const size_type& tile_size, const bool endpoints = false)
+  : image_size_(image_size)
+  , tile_size_ (tile_size )
+  , grid_size_ ((image_size.array() + tile_size.array() - 1) / tile_size.array())
+  , offsets_   (static_cast<std::size_t>(grid_size_.prod()), 0)
+  {
+    header_.endpoint_size = endpoints ? static_cast<std::uint32_t>(sizeof(endpoint_type)) : 0;
+    header_.scene_hash    = scene_hash;
+    header_.image_size[0] = image_size[0]; header_.image_size[1] = image_size[1];
+    header_.tile_size [0] = tile_size [0]; header_.tile_size [1] = tile_size [1];
+
+    if (exists(filepath))
+    {
+      const auto size = restore(filepath);
+      if (size > 0)
+      {
+        std::filesystem::resize_file(filepath, size); // Discards a torn record.
+        file_ = std::fopen(filepath.string().c_str(), "r+b");
+        if (!file_)
+          throw std::runtime_error("Failed fopen.");
+        return;
+      }
+    }
+
+    std::fill(offsets_.begin(), offsets_.end(), 0);
+    file_ = std::fopen(filepath.string().c_str(), "w+b");
+    if (!file_)
+      throw std::runtime_error("Failed fopen.");
+    write(&header_, sizeof(header_));
+    flush();
+  }
+  tile_checkpoint           (const tile_checkpoint&  that) = delete;
+  tile_checkpoint           (      tile_checkpoint&& temp) = delete;
+  virtual ~tile_checkpoint  ()
+  {
+    if (file_)
+      std::fclose(file_);
+  }
+  tile_checkpoint& operator=(const tile_checkpoint&  that) = delete;
+  tile_checkpoint& operator=(      tile_checkpoint&& temp) = delete;
+
+  std::int32_t tile_count    () const
+  {
+    return grid_size_.prod();
+  }
+  size_type    tile_offset   (const std::int32_t index) const
+  {
+    return unravel_index<size_type, true>(index, grid_size_).cwiseProduct(tile_size_);
+  }
+  size_type    tile_extent   (const std::int32_t index) const
+  {
+    return tile_size_.cwiseMin(image_size_ - tile_offset(index));
+  }
+  bool         endpoints     () const
+  {
+    return header_.endpoint_size != 0;
+  }
+
+  bool         finished      (const std::int32_t index) const
+  {
+    return offsets_[index] != 0;
+  }
+  std::int32_t finished_count() const
+  {
+    return static_cast<std::int32_t>(std::count_if(offsets_.begin(), offsets_.end(), [ ] (const std::uint64_t offset) { return offset != 0; }));
+  }
+
+  // Reads a finished tile, or its endpoints if the checkpoint holds endpoints.
+  image_type     tile          (const std::int32_t index)
+  {
+    image_type result(tile_extent(index), pixel_type());
+    seek(offsets_[index]);
+    read(result.data.data(), result.data.size() * sizeof(pixel_type));
+    return result;
+  }
+  endpoints_type tile_endpoints(const std::int32_t index)
+  {
+    if (!endpoints())
+      throw std::runtime_error("The checkpoint holds no endpoints.");
+
+    endpoints_type result(tile_extent(index));
+    seek(offsets_[index] + result.data.size() * sizeof(pixel_type));
+    read(result.data.data(), result.data.size() * sizeof(endpoint_type));
+    return result;
+  }
+  // Assembles the endpoints of all finished tiles into a buffer of the image size, e.g. to shade the frame against
+  // another background.
+  endpoints_type endpoints_of_image()
+  {
+    endpoints_type result(image_size_);
+    for (auto index = 0; index < tile_count(); ++index)
+    {
+      if (!finished(index))
+        continue;
+
+      const auto offset = tile_offset(index);
+      const auto tile   = tile_endpoints(index);
+      for (auto y = 0; y < tile.size[1]; ++y)
+        std::copy_n(
+          tile  .data.begin() + static_cast<std::size_t>(y) * tile.size[0], tile.size[0],
+          result.data.begin() + static_cast<std::size_t>(offset[0]) + static_cast<std::size_t>(offset[1] + y) * image_size_[0]);
+    }
+    return result;
+  }
+
+  // Appends a finished tile. The endpoints are required if the checkpoint holds endpoints, and ignored otherwise. The
+  // records are buffered until the next flush.
+  void         write         (const std::int32_t index, const image_type& tile, const endpoints_type* endpoints = nullptr)
+  {
+    if (tile.size != tile_extent(index) || (this->endpoints() && (!endpoints || endpoints->size != tile.size)))
+      throw std::runtime_error("The tile does not match the checkpoint.");
+
+    record entry;
+    entry.tile     = index;
+    entry.checksum = checksum(tile.data.data(), this->endpoints() ? endpoints->data.data() : nullptr, tile.data.size());
+
+    std::fseek(file_, 0, SEEK_END);
+    const auto position = tell();
+    write(&entry, sizeof(entry));
+    write(tile.data.data(), tile.data.size() * sizeof(pixel_type));
+    if (this->endpoints())
+      write(endpoints->data.data(), endpoints->data.size() * sizeof(endpoint_type));
+    offsets_[index] = position + sizeof(entry);
+  }
+  void         flush         ()
+  {
+    if (std::fflush(file_) != 0)
+      throw std::runtime_error("Failed fflush.");
+  }
+
+protected:
+  // Reads the records of an existing checkpoint of the same scene. Returns the size of its complete records, or zero if
+  // the checkpoint belongs to another scene.
+  std::uint64_t restore      (const std::filesystem::path& filepath)
+  {
+    file_ = std::fopen(filepath.string().c_str(), "rb");
+    if (!file_)
+      return 0;
+
+    header actual;
+    const auto matches = std::fread(&actual, sizeof(actual), 1, file_) == 1 && std::memcmp(&actual, &header_, sizeof(header)) == 0;
+
+    std::uint64_t size = matches ? sizeof(header) : 0;
+    std::vector<pixel_type>    pixels;
+    std::vector<endpoint_type> endpoints;
+    record                     entry;
+    while (matches && std::fread(&entry, sizeof(entry), 1, file_) == 1)
+    {
+      if (entry.tile < 0 || entry.tile >= tile_count())
+        break;
+
+      const auto count = static_cast<std::size_t>(tile_extent(entry.tile).prod());
+      pixels   .resize(count);
+      endpoints.resize(this->endpoints() ? count : 0);
+      if (std::fread(pixels   .data(), sizeof(pixel_type)   , pixels   .size(), file_) != pixels   .size() ||
+          std::fread(endpoints.data(), sizeof(endpoint_type), endpoints.size(), file_) != endpoints.size() ||
+          checksum(pixels.data(), this->endpoints() ? endpoints.data() : nullptr, count) != entry.checksum)
+        break;
+
+      offsets_[entry.tile] = size + sizeof(entry);
+      size += sizeof(entry) + count * sizeof(pixel_type) + endpoints.size() * sizeof(endpoint_type);
+    }
+
+    std::fclose(file_);
+    file_ = nullptr;
+    return size;
+  }
+
+  static std::uint64_t checksum(const pixel_type* pixels, const endpoint_type* endpoints, const std::size_t count)
+  {
+    hasher hasher;
+    hasher.add(pixels, count * sizeof(pixel_type));
+    if (endpoints)
+      hasher.add(endpoints, count * sizeof(endpoint_type));
+    return hasher.value();
+  }
+
+  void          write        (const void* data, const std::size_t size)
+  {
+    if (std::fwrite(data, 1, size, file_) != size)
+      throw std::runtime_error("Failed fwrite.");
+  }
+  void          read         (void* data, const std::size_t size)
+  {
+    if (std::fread(data, 1, size, file_) != size)
+      throw std::runtime_error("Failed fread.");
+  }
+  void          seek         (const std::uint64_t position)
+  {
+#ifdef _WIN32
+    const auto result = _fseeki64(file_, static_cast<__int64>(position), SEEK_SET);
+#else
+    const auto result = fseeko   (file_, static_cast<off_t  >(position), SEEK_SET);
+#endif
+    if (result != 0)
+      throw std::runtime_error("Failed fseek.");
+  }
+  std::uint64_t tell         () const
+  {
+#ifdef _WIN32
+    return static_cast<std::uint64_t>(_ftelli64(file_));
+#else
+    return static_cast<std::uint64_t>(ftello   (file_));
+#endif
+  }
+
+  header                     header_    ;
+  size_type                  image_size_;
+  size_type                  tile_size_ ;
+  size_type                  grid_size_ ;
+  std::vector<std::uint64_t> offsets_   ; // The position of the pixels of each finished tile, zero if unfinished.
+  std::FILE*                 file_      = nullptr;
+};
+}
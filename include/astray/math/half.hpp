@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <astray/parallel/thrust.hpp>
+
+namespace ast
+{
+// IEEE 754 binary16 storage type. Arithmetic is performed in single precision, the type only serves to halve the
+// size of large buffers. Conversion from single precision rounds to the nearest even value.
+struct half
+{
+  __device__ constexpr half    () = default;
+  __device__           half    (const float value) : bits(from_float(value))
+  {
+
+  }
+
+  __device__ operator float    () const
+  {
+    return to_float(bits);
+  }
+
+  __device__ static std::uint16_t from_float(const float value)
+  {
+    std::uint32_t single;
+    std::memcpy(&single, &value, sizeof(single));
+
+    const auto sign = static_cast<std::uint16_t>((single >> 16) & 0x8000);
+    single &= 0x7FFFFFFF;
+
+    if (single >= 0x7F800000) // Infinity or NaN.
+      return static_cast<std::uint16_t>(sign | 0x7C00 | (single > 0x7F800000 ? 0x0200 : 0));
+    if (single >= 0x477FF000) // Overflows to infinity after rounding.
+      return static_cast<std::uint16_t>(sign | 0x7C00);
+    if (single <  0x33000000) // Underflows to zero after rounding.
+      return sign;
+
+    if (single < 0x38800000)  // Subnormal.
+    {
+      const std::uint32_t mantissa  = (single & 0x007FFFFF) | 0x00800000;
+      const std::uint32_t shift     = 126 - (single >> 23);
+      const std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+      const std::uint32_t halfway   = 1u << (shift - 1);
+      auto                result    = mantissa >> shift;
+      if (remainder > halfway || (remainder == halfway && (result & 1)))
+        ++result;
+      return static_cast<std::uint16_t>(sign | result);
+    }
+
+    const std::uint32_t remainder = single & 0x1FFF;
+    auto                result    = (single - 0x38000000) >> 13;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+      ++result;
+    return static_cast<std::uint16_t>(sign | result);
+  }
+  __device__ static float         to_float  (const std::uint16_t value)
+  {
+    const std::uint32_t sign     = static_cast<std::uint32_t>(value & 0x8000) << 16;
+    const std::uint32_t exponent = (value >> 10) & 0x1F;
+    const std::uint32_t mantissa =  value        & 0x3FF;
+
+    if (exponent == 0) // Zero or subnormal.
+    {
+      const auto result = static_cast<float>(mantissa) * 5.9604644775390625e-8f; // 2^-24
+      return sign ? -result : result;
+    }
+
+    std::uint32_t single = exponent == 0x1F
+      ? sign | 0x7F800000 | (mantissa << 13)
+      : sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+    float result;
+    std::memcpy(&result, &single, sizeof(result));
+    return result;
+  }
+
+  std::uint16_t bits = 0;
+};
+}
@@ -12,4 +12,15 @@ struct ray
   vector_type position  = vector_type::Zero();
   vector_type direction = vector_type::Zero();
 };
-}
\ No newline at end of file
+
+// The derivatives of the position and direction of a ray with respect to the x and y pixel coordinates, i.e. the Jacobi
+// fields which relate it to the rays of the neighboring pixels.
+template <typename vector_type_>
+struct ray_differentials
+{
+  using vector_type = vector_type_;
+
+  vector_type position [2] = {vector_type::Zero(), vector_type::Zero()};
+  vector_type direction[2] = {vector_type::Zero(), vector_type::Zero()};
+};
+}
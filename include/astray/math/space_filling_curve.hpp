@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <astray/math/indexing.hpp>
+#include <astray/parallel/thrust.hpp>
+
+namespace ast
+{
+enum class space_filling_curve_type
+{
+  row_major,
+  morton   ,
+  hilbert
+};
+
+// Z-order curve. Interleaves the bits of the two components of the multi index.
+template <typename type>
+__device__ constexpr type        morton_decode (std::size_t index)
+{
+  type multi_index {};
+  for (std::size_t bit = 0; bit < sizeof(std::size_t) * 4; ++bit)
+  {
+    multi_index[0] |= static_cast<typename type::value_type>((index >> (2 * bit    )) & 1) << bit;
+    multi_index[1] |= static_cast<typename type::value_type>((index >> (2 * bit + 1)) & 1) << bit;
+  }
+  return multi_index;
+}
+template <typename type>
+__device__ constexpr std::size_t morton_encode (const type& multi_index)
+{
+  std::size_t index(0);
+  for (std::size_t bit = 0; bit < sizeof(std::size_t) * 4; ++bit)
+  {
+    index |= ((static_cast<std::size_t>(multi_index[0]) >> bit) & 1) << (2 * bit    );
+    index |= ((static_cast<std::size_t>(multi_index[1]) >> bit) & 1) << (2 * bit + 1);
+  }
+  return index;
+}
+
+// Hilbert curve over a square domain of side length (which must be a power of two).
+template <typename type>
+__device__ constexpr type        hilbert_decode(std::size_t index, const std::size_t side_length)
+{
+  std::size_t x(0), y(0);
+  for (std::size_t scale = 1; scale < side_length; scale *= 2)
+  {
+    const std::size_t rx = 1 & (index / 2);
+    const std::size_t ry = 1 & (index ^ rx);
+    if (ry == 0)
+    {
+      if (rx == 1)
+      {
+        x = scale - 1 - x;
+        y = scale - 1 - y;
+      }
+      const auto temporary = x;
+      x = y;
+      y = temporary;
+    }
+    x     += scale * rx;
+    y     += scale * ry;
+    index /= 4;
+  }
+
+  type multi_index {};
+  multi_index[0] = static_cast<typename type::value_type>(x);
+  multi_index[1] = static_cast<typename type::value_type>(y);
+  return multi_index;
+}
+template <typename type>
+__device__ constexpr std::size_t hilbert_encode(const type& multi_index, const std::size_t side_length)
+{
+  auto        x = static_cast<std::size_t>(multi_index[0]);
+  auto        y = static_cast<std::size_t>(multi_index[1]);
+  std::size_t index(0);
+  for (std::size_t scale = side_length / 2; scale > 0; scale /= 2)
+  {
+    const std::size_t rx = (x & scale) > 0;
+    const std::size_t ry = (y & scale) > 0;
+    index += scale * scale * ((3 * rx) ^ ry);
+    if (ry == 0)
+    {
+      if (rx == 1)
+      {
+        x = side_length - 1 - x;
+        y = side_length - 1 - y;
+      }
+      const auto temporary = x;
+      x = y;
+      y = temporary;
+    }
+  }
+  return index;
+}
+
+template <typename type>
+__device__ constexpr type        curve_decode  (const space_filling_curve_type curve, const std::size_t index, const std::size_t side_length)
+{
+  if (curve == space_filling_curve_type::hilbert)
+    return hilbert_decode<type>(index, side_length);
+  if (curve == space_filling_curve_type::morton)
+    return morton_decode <type>(index);
+
+  type multi_index {};
+  multi_index[0] = static_cast<typename type::value_type>(index % side_length);
+  multi_index[1] = static_cast<typename type::value_type>(index / side_length);
+  return multi_index;
+}
+
+// Returns the linear (ravelled) indices of a 2D domain of the given dimensions in the order of traversal.
+// The domain is split into square tiles of tile_size (which must be a power of two), the tiles are traversed
+// along the curve, and the elements within each tile are traversed along the same curve. Tiles and elements
+// which lie outside the domain are skipped, hence the result is a permutation of [0, dimensions.prod()).
+template <typename type, bool fortran_order = false, typename index_type = std::uint32_t>
+std::vector<index_type> traversal_order(const type& dimensions, const space_filling_curve_type curve, const std::size_t tile_size = 8)
+{
+  std::vector<index_type> indices;
+  indices.reserve(static_cast<std::size_t>(dimensions[0]) * static_cast<std::size_t>(dimensions[1]));
+
+  if (curve == space_filling_curve_type::row_major)
+  {
+    for (std::size_t i = 0; i < indices.capacity(); ++i)
+      indices.push_back(static_cast<index_type>(i));
+    return indices;
+  }
+  if (tile_size == 0 || (tile_size & (tile_size - 1)) != 0)
+    throw std::runtime_error("The tile size is not a power of two.");
+
+  const std::size_t grid_size_x = (dimensions[0] + tile_size - 1) / tile_size;
+  const std::size_t grid_size_y = (dimensions[1] + tile_size - 1) / tile_size;
+  std::size_t       grid_side   = 1;
+  while (grid_side < std::max(grid_size_x, grid_size_y))
+    grid_side *= 2;
+
+  for (std::size_t tile_index = 0; tile_index < grid_side * grid_side; ++tile_index)
+  {
+    const auto tile = curve_decode<type>(curve, tile_index, grid_side);
+    if (static_cast<std::size_t>(tile[0]) >= grid_size_x || static_cast<std::size_t>(tile[1]) >= grid_size_y)
+      continue;
+
+    for (std::size_t element_index = 0; element_index < tile_size * tile_size; ++element_index)
+    {
+      auto multi_index = curve_decode<type>(curve, element_index, tile_size);
+      multi_index[0] += tile[0] * static_cast<typename type::value_type>(tile_size);
+      multi_index[1] += tile[1] * static_cast<typename type::value_type>(tile_size);
+      if (multi_index[0] >= dimensions[0] || multi_index[1] >= dimensions[1])
+        continue;
+
+      indices.push_back(static_cast<index_type>(ravel_multi_index<type, fortran_order>(multi_index, dimensions)));
+    }
+  }
+  return indices;
+}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <astray/math/constants.hpp>
+#include <astray/math/coordinate_system.hpp>
+#include <astray/math/indexing.hpp>
+#include <astray/math/linear_algebra.hpp>
+#include <astray/media/image.hpp>
+
+namespace ast
+{
+// An environment map as six cube faces, resampled from an equirectangular image. A direction is looked up by selecting
+// the face of its major axis and dividing the other two components by it, without any trigonometric functions. Each face
+// is stored in square tiles, so that the rays of neighboring pixels sample neighboring memory regardless of direction.
+//
+// Faces are ordered +x, -x, +y, -y, +z, -z. The texel (u, v) of a face spans the components (s, t) in [-1, 1], with
+// (s, t) = (y, z) on the x faces, (x, z) on the y faces and (x, y) on the z faces.
+template <typename type>
+class cubemap
+{
+public:
+  static constexpr std::int32_t tile_size = 8;
+
+  // The face size defaults to a quarter of the width of the equirectangular image, which retains its resolution at the
+  // equator. It is rounded up to a multiple of the tile size.
+  explicit cubemap  (const type* equirectangular, const vector2<std::int32_t>& size, std::int32_t face_size = 0)
+  {
+    if (size[0] <= 0 || size[1] <= 0)
+      throw std::runtime_error("Cannot build a cubemap from an empty image.");
+    if (face_size <= 0)
+      face_size = std::max(size[0] / 4, 1);
+    face_size_ = (face_size + tile_size - 1) / tile_size * tile_size;
+    data_.resize(6 * static_cast<std::size_t>(face_size_) * face_size_);
+
+    using constants = constants<double>;
+    for (auto face = 0; face < 6; ++face)
+      for (auto v = 0; v < face_size_; ++v)
+        for (auto u = 0; u < face_size_; ++u)
+        {
+          const auto s = 2.0 * (u + 0.5) / face_size_ - 1.0;
+          const auto t = 2.0 * (v + 0.5) / face_size_ - 1.0;
+          const auto m = face % 2 == 0 ? 1.0 : -1.0;
+
+          // Same conversion and indexing as the equirectangular shading in ray_tracer.
+          vector4<double> direction(0.0, 0.0, 0.0, 0.0);
+          if      (face < 2) direction = vector4<double>(0.0, m, s, t);
+          else if (face < 4) direction = vector4<double>(0.0, s, m, t);
+          else               direction = vector4<double>(0.0, s, t, m);
+          convert<coordinate_system_type::cartesian, coordinate_system_type::spherical>(direction);
+
+          vector2<std::int32_t> index(
+            static_cast<std::int32_t>(std::floor(direction[3] / constants::two_pi * size[0])),
+            static_cast<std::int32_t>(std::floor(direction[2] / constants::pi     * size[1])));
+          index[0] = std::clamp(index[0], 0, size[0] - 1);
+          index[1] = std::clamp(index[1], 0, size[1] - 1);
+
+          data_[texel_index(face, u, v, face_size_)] = equirectangular[ravel_multi_index<vector2<std::int32_t>, true>(index, size)];
+        }
+  }
+  explicit cubemap  (const image<type>& equirectangular, const std::int32_t face_size = 0)
+  : cubemap(equirectangular.data.data(), equirectangular.size, face_size)
+  {
+
+  }
+  cubemap           (const cubemap&  that) = default;
+  cubemap           (      cubemap&& temp) = default;
+  virtual ~cubemap  ()                     = default;
+  cubemap& operator=(const cubemap&  that) = default;
+  cubemap& operator=(      cubemap&& temp) = default;
+
+  std::int32_t             face_size() const
+  {
+    return face_size_;
+  }
+  const std::vector<type>& data     () const
+  {
+    return data_;
+  }
+
+  __device__ __host__ static std::size_t texel_index(const std::int32_t face, const std::int32_t u, const std::int32_t v, const std::int32_t face_size)
+  {
+    const auto tiles = face_size / tile_size;
+    const auto tile  = static_cast<std::size_t>(v / tile_size) * tiles + u / tile_size;
+    return (static_cast<std::size_t>(face) * tiles * tiles + tile) * tile_size * tile_size + (v % tile_size) * tile_size + u % tile_size;
+  }
+  // Samples (nearest) the cubemap data in the given, not necessarily normalized, direction.
+  template <typename scalar_type>
+  __device__ __host__ static const type& sample     (const type* data, const std::int32_t face_size, const scalar_type x, const scalar_type y, const scalar_type z)
+  {
+    const auto ax = std::abs(x), ay = std::abs(y), az = std::abs(z);
+
+    std::int32_t face;
+    scalar_type  major, s, t;
+    if      (ax >= ay && ax >= az) { face = x >= 0 ? 0 : 1; major = ax; s = y; t = z; }
+    else if (ay >= az)             { face = y >= 0 ? 2 : 3; major = ay; s = x; t = z; }
+    else                           { face = z >= 0 ? 4 : 5; major = az; s = x; t = y; }
+
+    const auto scale = static_cast<scalar_type>(face_size) / (2 * major);
+    const auto half  = static_cast<scalar_type>(face_size) / 2;
+    const auto u     = std::min(std::max(static_cast<std::int32_t>(s * scale + half), 0), face_size - 1);
+    const auto v     = std::min(std::max(static_cast<std::int32_t>(t * scale + half), 0), face_size - 1);
+    return data[texel_index(face, u, v, face_size)];
+  }
+
+protected:
+  std::int32_t      face_size_;
+  std::vector<type> data_     ;
+};
+}
@@ -2,11 +2,14 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <fstream>
 #include <stdexcept>
 #include <vector>
 
 #include <astray/math/indexing.hpp>
 #include <astray/math/linear_algebra.hpp>
+#include <astray/media/qoi.hpp>
+#include <astray/utility/memory_mapped_file.hpp>
 #include <astray/utility/warning.hpp>
 
 DISABLE_WARNING_PUSH
@@ -53,6 +56,16 @@ public:
     if (!exists(filepath))
       throw std::runtime_error("File does not exist!");
 
+    if (filepath.extension() == ".qoi")
+    {
+      const memory_mapped_file file(filepath);
+      std::uint32_t width, height;
+      const auto    decoded = qoi::decode(file.data(), file.size(), width, height, sizeof(type)); // Dimensions fit into 32-bit signed integers.
+      size = vector2<std::int32_t>(static_cast<std::int32_t>(width), static_cast<std::int32_t>(height));
+      data = std::vector<type>(reinterpret_cast<const type*>(decoded.data()), reinterpret_cast<const type*>(decoded.data()) + size.prod());
+      return;
+    }
+
     auto components = 0;
     auto* const raw = reinterpret_cast<type*>(stbi_load(filepath.string().c_str(), &size[0], &size[1], &components, sizeof(type)));
     data = std::vector<type>(raw, raw + size[0] * size[1]); // Copy will not be necessary if https://github.com/nothings/stb/issues/58 is resolved.
@@ -65,6 +78,12 @@ public:
     else if (extension == ".jpg") stbi_write_jpg(filepath.string().c_str(), size[0], size[1], sizeof(type), data.data(), 100);
     else if (extension == ".png") stbi_write_png(filepath.string().c_str(), size[0], size[1], sizeof(type), data.data(), size[0] * sizeof(type));
     else if (extension == ".tga") stbi_write_tga(filepath.string().c_str(), size[0], size[1], sizeof(type), data.data());
+    else if (extension == ".qoi") // Lossless and fast, encoded in parallel bands of rows.
+    {
+      const auto    encoded = qoi::encode(reinterpret_cast<const std::uint8_t*>(data.data()), size[0], size[1], sizeof(type));
+      std::ofstream stream(filepath, std::ios::binary);
+      stream.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    }
     else throw std::runtime_error("Unsupported extension!");
   }
   
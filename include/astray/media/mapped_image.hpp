@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <astray/math/linear_algebra.hpp>
+#include <astray/media/image.hpp>
+#include <astray/utility/memory_mapped_file.hpp>
+
+namespace ast
+{
+// A read-only image in a raw file (a header followed by the pixels), accessed in place through a memory map. Serves as
+// a cache of decoded images: the pixels are neither decoded nor copied, the operating system pages them in on demand.
+template <typename type>
+class mapped_image
+{
+public:
+  using size_type = vector2<std::int32_t>;
+
+  struct header
+  {
+    char          magic     [8] = {'A', 'S', 'T', 'R', 'A', 'Y', 'I', 'M'};
+    std::uint32_t version       = 1;
+    std::uint32_t pixel_size    = sizeof(type);
+    std::int32_t  size      [2] = {0, 0};
+  };
+
+  explicit mapped_image  (const std::filesystem::path& filepath) : file_(filepath)
+  {
+    header expected, actual;
+    if (file_.size() < sizeof(header))
+      throw std::runtime_error("Invalid mapped image!");
+
+    std::memcpy(&actual, file_.data(), sizeof(header));
+    if (std::memcmp(actual.magic, expected.magic, sizeof(expected.magic)) != 0 ||
+        actual.version    != expected.version    ||
+        actual.pixel_size != expected.pixel_size )
+      throw std::runtime_error("Invalid mapped image!");
+
+    size = size_type(actual.size[0], actual.size[1]);
+    if (file_.size() != sizeof(header) + size.prod() * sizeof(type))
+      throw std::runtime_error("Invalid mapped image!");
+  }
+  mapped_image           (const mapped_image&  that) = delete;
+  mapped_image           (      mapped_image&& temp) = default;
+  virtual ~mapped_image  ()                          = default;
+  mapped_image& operator=(const mapped_image&  that) = delete;
+  mapped_image& operator=(      mapped_image&& temp) = default;
+
+  const type*  data    () const
+  {
+    return reinterpret_cast<const type*>(file_.data() + sizeof(header));
+  }
+  image<type>  to_image() const
+  {
+    image<type> result(size);
+    std::memcpy(result.data.data(), data(), result.data.size() * sizeof(type));
+    return result;
+  }
+
+  static void         save       (const std::filesystem::path& filepath, const image<type>& value)
+  {
+    header header;
+    header.size[0] = value.size[0];
+    header.size[1] = value.size[1];
+
+    memory_mapped_file file(filepath, sizeof(header) + value.data.size() * sizeof(type));
+    std::memcpy(file.data()                 , &header          , sizeof(header));
+    std::memcpy(file.data() + sizeof(header), value.data.data(), value.data.size() * sizeof(type));
+  }
+  // Maps the cache of the given image (by default next to it, with the additional extension .raw). The cache is created
+  // by decoding the image if it does not exist or is older than the image.
+  static mapped_image load_cached(const std::filesystem::path& filepath, std::filesystem::path cache_filepath = {})
+  {
+    if (!exists(filepath))
+      throw std::runtime_error("File does not exist!");
+
+    if (cache_filepath.empty())
+      cache_filepath = filepath.string() + ".raw";
+
+    std::error_code error;
+    if (!exists(cache_filepath) || last_write_time(cache_filepath, error) < last_write_time(filepath))
+    {
+      // Written under a temporary name and renamed, so that concurrent processes (e.g. MPI ranks) never map a partial cache.
+      auto temporary_filepath = cache_filepath;
+      temporary_filepath += ".tmp" + std::to_string(std::random_device()());
+      save  (temporary_filepath, image<type>(filepath));
+      rename(temporary_filepath, cache_filepath);
+    }
+    return mapped_image(cache_filepath);
+  }
+
+  size_type          size;
+
+protected:
+  memory_mapped_file file_;
+};
+}
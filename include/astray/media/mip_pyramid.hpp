@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <astray/math/constants.hpp>
+#include <astray/math/indexing.hpp>
+#include <astray/math/linear_algebra.hpp>
+#include <astray/media/image.hpp>
+
+namespace ast
+{
+// A pyramid of pre-filtered versions of an equirectangular image, each half the size of the previous one (2x2 box filter)
+// down to 1x1. The levels are stored one after another in a single buffer.
+template <typename type>
+class mip_pyramid
+{
+public:
+  using size_type = vector2<std::int32_t>;
+
+  explicit mip_pyramid  (const type* source, const size_type& size) : size_(size)
+  {
+    if (size[0] <= 0 || size[1] <= 0)
+      throw std::runtime_error("Cannot build a mip pyramid from an empty image.");
+
+    level_count_ = 1;
+    while (level_size(level_count_ - 1, size_) != size_type(1, 1))
+      ++level_count_;
+    data_.resize(level_offset(level_count_, size_));
+    std::copy_n(source, size.prod(), data_.begin());
+
+    for (auto level = 1; level < level_count_; ++level)
+    {
+      const auto  source_size = level_size  (level - 1, size_);
+      const auto  target_size = level_size  (level    , size_);
+      const type* parent      = data_.data() + level_offset(level - 1, size_);
+      type*       child       = data_.data() + level_offset(level    , size_);
+      for (auto y = 0; y < target_size[1]; ++y)
+        for (auto x = 0; x < target_size[0]; ++x)
+        {
+          const auto x0 = std::min(2 * x, source_size[0] - 1), x1 = std::min(2 * x + 1, source_size[0] - 1);
+          const auto y0 = std::min(2 * y, source_size[1] - 1), y1 = std::min(2 * y + 1, source_size[1] - 1);
+          const auto sum =
+            parent[x0 + y0 * source_size[0]].template cast<std::int32_t>() + parent[x1 + y0 * source_size[0]].template cast<std::int32_t>() +
+            parent[x0 + y1 * source_size[0]].template cast<std::int32_t>() + parent[x1 + y1 * source_size[0]].template cast<std::int32_t>();
+          child[x + y * target_size[0]] = ((sum.array() + 2) / 4).template cast<typename type::Scalar>();
+        }
+    }
+  }
+  explicit mip_pyramid  (const image<type>& source)
+  : mip_pyramid(source.data.data(), source.size)
+  {
+
+  }
+  mip_pyramid           (const mip_pyramid&  that) = default;
+  mip_pyramid           (      mip_pyramid&& temp) = default;
+  virtual ~mip_pyramid  ()                         = default;
+  mip_pyramid& operator=(const mip_pyramid&  that) = default;
+  mip_pyramid& operator=(      mip_pyramid&& temp) = default;
+
+  const size_type&         size       () const
+  {
+    return size_;
+  }
+  std::int32_t             level_count() const
+  {
+    return level_count_;
+  }
+  const std::vector<type>& data       () const
+  {
+    return data_;
+  }
+  image<type>              level      (const std::int32_t index) const
+  {
+    image<type> result(level_size(index, size_));
+    std::copy_n(data_.begin() + level_offset(index, size_), result.data.size(), result.data.begin());
+    return result;
+  }
+
+  __device__ __host__ static size_type   level_size  (const std::int32_t level, const size_type& size)
+  {
+    return size_type(std::max(size[0] >> level, 1), std::max(size[1] >> level, 1));
+  }
+  __device__ __host__ static std::size_t level_offset(const std::int32_t level, const size_type& size)
+  {
+    std::size_t offset = 0;
+    for (auto i = 0; i < level; ++i)
+      offset += static_cast<std::size_t>(level_size(i, size).prod());
+    return offset;
+  }
+
+  // Samples the spherical angles (theta, phi) at a fractional level, nearest within and linear between levels. Level 0 is
+  // identical to the nearest lookup of the equirectangular image.
+  template <typename scalar_type>
+  __device__ __host__ static type sample(const type* data, const size_type& size, const std::int32_t level_count, const scalar_type theta, const scalar_type phi, scalar_type level)
+  {
+    level = std::min(level, static_cast<scalar_type>(level_count - 1));
+    if (!(level > static_cast<scalar_type>(0))) // Includes NaN.
+      return sample_level(data, size, 0, theta, phi);
+
+    const auto lower  = static_cast<std::int32_t>(level);
+    const auto weight = level - static_cast<scalar_type>(lower);
+    const auto first  = sample_level(data, size, lower                                , theta, phi).template cast<scalar_type>().eval();
+    const auto second = sample_level(data, size, std::min(lower + 1, level_count - 1), theta, phi).template cast<scalar_type>().eval();
+    return ((static_cast<scalar_type>(1) - weight) * first + weight * second).array().round().template cast<typename type::Scalar>();
+  }
+  template <typename scalar_type>
+  __device__ __host__ static type sample_level(const type* data, const size_type& size, const std::int32_t level, const scalar_type theta, const scalar_type phi)
+  {
+    using constants = constants<scalar_type>;
+
+    const auto level_size = mip_pyramid::level_size(level, size);
+    size_type  index(
+      std::floor(phi   / constants::two_pi * static_cast<scalar_type>(level_size[0])),
+      std::floor(theta / constants::pi     * static_cast<scalar_type>(level_size[1])));
+    index[0] = std::min(std::max(index[0], 0), level_size[0] - 1);
+    index[1] = std::min(std::max(index[1], 0), level_size[1] - 1);
+    return data[level_offset(level, size) + ravel_multi_index<size_type, true>(index, level_size)];
+  }
+
+protected:
+  size_type         size_       ;
+  std::int32_t      level_count_;
+  std::vector<type> data_       ;
+};
+}
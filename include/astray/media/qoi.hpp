@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ast
+{
+// The "Quite OK Image" format (https://qoiformat.org/qoi-specification.pdf). Encoding is split into bands of rows which
+// are compressed in parallel. Each band starts with a literal pixel and only refers to the entries of the color index
+// it has written itself, hence the concatenated bands form a single standard QOI stream, decodable by any QOI decoder.
+namespace qoi
+{
+constexpr std::uint8_t op_index = 0x00;
+constexpr std::uint8_t op_diff  = 0x40;
+constexpr std::uint8_t op_luma  = 0x80;
+constexpr std::uint8_t op_run   = 0xC0;
+constexpr std::uint8_t op_rgb   = 0xFE;
+constexpr std::uint8_t op_rgba  = 0xFF;
+constexpr std::uint8_t mask     = 0xC0;
+
+constexpr std::size_t   header_size     = 14;
+constexpr std::uint8_t  padding     [8] = {0, 0, 0, 0, 0, 0, 0, 1};
+constexpr std::uint32_t max_pixel_count = 400000000; // The limit of the specification, guards decoders against hostile headers.
+
+struct rgba
+{
+  constexpr bool operator==(const rgba& that) const
+  {
+    return r == that.r && g == that.g && b == that.b && a == that.a;
+  }
+  constexpr bool operator!=(const rgba& that) const
+  {
+    return !(*this == that);
+  }
+
+  std::uint8_t r = 0, g = 0, b = 0, a = 255;
+};
+
+constexpr std::size_t hash(const rgba& pixel)
+{
+  return (pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) % 64;
+}
+
+// Encodes the pixels [begin, end) of an image with the given number of channels (3 or 4) as an independent band.
+inline void encode_band(const std::uint8_t* data, const std::size_t begin, const std::size_t end, const std::uint32_t channels, std::vector<std::uint8_t>& result)
+{
+  result.reserve((end - begin) * (channels + 1) / 2);
+
+  std::array<rgba, 64> index   {};
+  std::array<bool, 64> written {};
+  rgba                 previous;
+  std::uint32_t        run     = 0;
+
+  for (auto i = begin; i < end; ++i)
+  {
+    const auto* source = data + i * channels;
+    const rgba  pixel {source[0], source[1], source[2], channels == 4 ? source[3] : static_cast<std::uint8_t>(255)};
+
+    if (i != begin && pixel == previous)
+    {
+      if (++run == 62)
+      {
+        result.push_back(static_cast<std::uint8_t>(op_run | (run - 1)));
+        run = 0;
+      }
+      continue;
+    }
+    if (run > 0)
+    {
+      result.push_back(static_cast<std::uint8_t>(op_run | (run - 1)));
+      run = 0;
+    }
+
+    const auto slot = hash(pixel);
+    if (i != begin && written[slot] && index[slot] == pixel)
+      result.push_back(static_cast<std::uint8_t>(op_index | slot));
+    else
+    {
+      index  [slot] = pixel;
+      written[slot] = true;
+
+      if (i == begin) // The previous pixel is unknown to the band, the first one is always literal.
+      {
+        result.insert(result.end(), {channels == 4 ? op_rgba : op_rgb, pixel.r, pixel.g, pixel.b});
+        if (channels == 4)
+          result.push_back(pixel.a);
+      }
+      else if (pixel.a == previous.a)
+      {
+        const auto dr    = static_cast<std::int8_t>(pixel.r - previous.r);
+        const auto dg    = static_cast<std::int8_t>(pixel.g - previous.g);
+        const auto db    = static_cast<std::int8_t>(pixel.b - previous.b);
+        const auto dr_dg = static_cast<std::int8_t>(dr - dg);
+        const auto db_dg = static_cast<std::int8_t>(db - dg);
+
+        if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2)
+          result.push_back(static_cast<std::uint8_t>(op_diff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+        else if (dg > -33 && dg < 32 && dr_dg > -9 && dr_dg < 8 && db_dg > -9 && db_dg < 8)
+          result.insert(result.end(), {static_cast<std::uint8_t>(op_luma | (dg + 32)), static_cast<std::uint8_t>((dr_dg + 8) << 4 | (db_dg + 8))});
+        else
+          result.insert(result.end(), {op_rgb, pixel.r, pixel.g, pixel.b});
+      }
+      else
+        result.insert(result.end(), {op_rgba, pixel.r, pixel.g, pixel.b, pixel.a});
+    }
+    previous = pixel;
+  }
+  if (run > 0)
+    result.push_back(static_cast<std::uint8_t>(op_run | (run - 1)));
+}
+
+// Encodes an image of interleaved 8-bit channels (3 or 4) into a QOI stream, using band_count threads (0 for all
+// hardware threads).
+inline std::vector<std::uint8_t> encode(const std::uint8_t* data, const std::uint32_t width, const std::uint32_t height, const std::uint32_t channels, std::size_t band_count = 0)
+{
+  if (channels != 3 && channels != 4)
+    throw std::runtime_error("QOI supports 3 or 4 channels only.");
+
+  if (band_count == 0)
+    band_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+  band_count = std::clamp<std::size_t>(band_count, 1, std::max<std::uint32_t>(height, 1));
+
+  const auto                             rows_per_band = (height + band_count - 1) / band_count;
+  std::vector<std::vector<std::uint8_t>> bands(band_count);
+  std::vector<std::thread>               threads;
+  for (std::size_t i = 0; i < band_count; ++i)
+  {
+    const auto begin = std::min<std::size_t>(i       * rows_per_band, height) * width;
+    const auto end   = std::min<std::size_t>((i + 1) * rows_per_band, height) * width;
+    if (i == 0)
+      continue;
+    threads.emplace_back([&, i, begin, end] { encode_band(data, begin, end, channels, bands[i]); });
+  }
+  encode_band(data, 0, std::min<std::size_t>(rows_per_band, height) * width, channels, bands[0]);
+  for (auto& thread : threads)
+    thread.join();
+
+  std::size_t size = header_size + sizeof(padding);
+  for (const auto& band : bands)
+    size += band.size();
+
+  std::vector<std::uint8_t> result;
+  result.reserve(size);
+  result.insert(result.end(), {'q', 'o', 'i', 'f',
+    static_cast<std::uint8_t>(width  >> 24), static_cast<std::uint8_t>(width  >> 16), static_cast<std::uint8_t>(width  >> 8), static_cast<std::uint8_t>(width ),
+    static_cast<std::uint8_t>(height >> 24), static_cast<std::uint8_t>(height >> 16), static_cast<std::uint8_t>(height >> 8), static_cast<std::uint8_t>(height),
+    static_cast<std::uint8_t>(channels), 0});
+  for (const auto& band : bands)
+    result.insert(result.end(), band.begin(), band.end());
+  result.insert(result.end(), std::begin(padding), std::end(padding));
+  return result;
+}
+
+// Decodes a QOI stream into interleaved 8-bit channels (3 or 4, independent of the channels of the stream).
+inline std::vector<std::uint8_t> decode(const std::uint8_t* data, const std::size_t size, std::uint32_t& width, std::uint32_t& height, const std::uint32_t channels)
+{
+  if (size < header_size + sizeof(padding) || data[0] != 'q' || data[1] != 'o' || data[2] != 'i' || data[3] != 'f')
+    throw std::runtime_error("Invalid QOI stream!");
+  if (channels != 3 && channels != 4)
+    throw std::runtime_error("QOI supports 3 or 4 channels only.");
+
+  width  = static_cast<std::uint32_t>(data[4]) << 24 | static_cast<std::uint32_t>(data[5]) << 16 | static_cast<std::uint32_t>(data[ 6]) << 8 | data[ 7];
+  height = static_cast<std::uint32_t>(data[8]) << 24 | static_cast<std::uint32_t>(data[9]) << 16 | static_cast<std::uint32_t>(data[10]) << 8 | data[11];
+
+  // Validated before allocating, as the product of the dimensions may overflow.
+  if (width == 0 || height == 0 || width > max_pixel_count / height)
+    throw std::runtime_error("Invalid QOI dimensions!");
+
+  const auto                pixel_count = static_cast<std::size_t>(width) * height;
+  std::vector<std::uint8_t> result(pixel_count * channels);
+
+  std::array<rgba, 64> index    {};
+  rgba                 pixel    ;
+  std::uint32_t        run      = 0;
+  std::size_t          position = header_size;
+  const auto           end      = size - sizeof(padding);
+
+  for (std::size_t i = 0; i < pixel_count; ++i)
+  {
+    if (run > 0)
+      --run;
+    else if (position < end)
+    {
+      const auto op = data[position++];
+      if      (op == op_rgb)
+      {
+        pixel.r = data[position++];
+        pixel.g = data[position++];
+        pixel.b = data[position++];
+      }
+      else if (op == op_rgba)
+      {
+        pixel.r = data[position++];
+        pixel.g = data[position++];
+        pixel.b = data[position++];
+        pixel.a = data[position++];
+      }
+      else if ((op & mask) == op_index)
+        pixel = index[op];
+      else if ((op & mask) == op_diff)
+      {
+        pixel.r += ((op >> 4) & 0x03) - 2;
+        pixel.g += ((op >> 2) & 0x03) - 2;
+        pixel.b += ( op       & 0x03) - 2;
+      }
+      else if ((op & mask) == op_luma)
+      {
+        const auto second = data[position++];
+        const auto dg     = (op & 0x3F) - 32;
+        pixel.r += dg - 8 + ((second >> 4) & 0x0F);
+        pixel.g += dg;
+        pixel.b += dg - 8 + ( second       & 0x0F);
+      }
+      else
+        run = op & 0x3F;
+
+      index[hash(pixel)] = pixel;
+    }
+
+    auto* target = result.data() + i * channels;
+    target[0] = pixel.r;
+    target[1] = pixel.g;
+    target[2] = pixel.b;
+    if (channels == 4)
+      target[3] = pixel.a;
+  }
+  return result;
+}
+}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include <astray/math/linear_algebra.hpp>
+#include <astray/media/image.hpp>
+
+namespace ast
+{
+enum class raw_video_format
+{
+  y4m, // YUV4MPEG2 with full range (XCOLORRANGE=FULL) 4:2:0 chroma sited like JPEG (C420jpeg).
+  rgb  // Headerless packed 24-bit RGB.
+};
+
+// Streams uncompressed frames to a file, or to the standard output if the filepath is "-", without any dependencies.
+// Each frame is written with a single sequential write, for consumption by an external encoder, e.g.:
+// ./video | ffmpeg -i - -c:v libx264 video.mp4
+// ./video | ffmpeg -f rawvideo -pixel_format rgb24 -video_size 1920x1080 -framerate 30 -i - video.mp4
+class raw_video
+{
+public:
+  using image_type = image<vector3<std::uint8_t>>;
+
+  explicit raw_video  (
+    const std::filesystem::path& filepath   ,
+    const vector2<std::int32_t>& size       = vector2<std::int32_t>(1920, 1080),
+    const std::int32_t           frame_rate = 30,
+    const raw_video_format       format     = raw_video_format::y4m)
+  : size_(size), format_(format)
+  {
+    if (filepath == "-")
+    {
+      file_ = stdout;
+#ifdef _WIN32
+      _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    }
+    else
+      file_ = std::fopen(filepath.string().c_str(), "wb");
+    if (!file_)
+      throw std::runtime_error("Failed fopen.");
+    std::setvbuf(file_, nullptr, _IONBF, 0); // Frames are written in one piece, intermediate buffering is a redundant copy.
+
+    if (format_ == raw_video_format::y4m)
+    {
+      const auto header = "YUV4MPEG2 W" + std::to_string(size[0]) + " H" + std::to_string(size[1]) + " F" + std::to_string(frame_rate) + ":1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n";
+      write(header.data(), header.size());
+
+      const std::string frame_header = "FRAME\n";
+      const auto        chroma_size  = static_cast<std::size_t>((size[0] + 1) / 2) * static_cast<std::size_t>((size[1] + 1) / 2);
+      buffer_.resize(frame_header.size() + static_cast<std::size_t>(size.prod()) + 2 * chroma_size);
+      std::copy(frame_header.begin(), frame_header.end(), buffer_.begin());
+    }
+  }
+  raw_video           (const raw_video&  that) = delete;
+  raw_video           (      raw_video&& temp) = delete;
+  virtual ~raw_video  ()
+  {
+    if (file_ == stdout)
+      std::fflush(file_);
+    else
+      std::fclose(file_);
+  }
+  raw_video& operator=(const raw_video&  that) = delete;
+  raw_video& operator=(      raw_video&& temp) = delete;
+
+  void append(const image_type& frame)
+  {
+    if (frame.size != size_)
+      throw std::runtime_error("Frame size does not match the video size.");
+
+    if (format_ == raw_video_format::rgb)
+    {
+      write(frame.data.data(), frame.data.size() * sizeof(vector3<std::uint8_t>));
+      return;
+    }
+
+    convert(frame);
+    write(buffer_.data(), buffer_.size());
+  }
+
+protected:
+  // Converts to full range BT.601 (JPEG) YCbCr in 16-bit fixed point. The chroma of each 2x2 block is computed from its
+  // mean color, odd sizes replicate the last row and column.
+  void convert(const image_type& frame)
+  {
+    const auto width         = size_[0];
+    const auto height        = size_[1];
+    const auto chroma_width  = (width  + 1) / 2;
+    const auto chroma_height = (height + 1) / 2;
+
+    auto* y_plane  = buffer_.data() + 6; // After "FRAME\n".
+    auto* cb_plane = y_plane  + static_cast<std::size_t>(width) * height;
+    auto* cr_plane = cb_plane + static_cast<std::size_t>(chroma_width) * chroma_height;
+
+    for (std::size_t i = 0; i < frame.data.size(); ++i)
+    {
+      const auto& pixel = frame.data[i];
+      y_plane[i] = static_cast<std::uint8_t>((19595 * pixel[0] + 38470 * pixel[1] + 7471 * pixel[2] + 32768) >> 16);
+    }
+
+    for (auto y = 0; y < chroma_height; ++y)
+    {
+      const auto y0 = 2 * y, y1 = std::min(2 * y + 1, height - 1);
+      for (auto x = 0; x < chroma_width; ++x)
+      {
+        const auto  x0 = 2 * x, x1 = std::min(2 * x + 1, width - 1);
+        const auto& p00 = frame.data[x0 + y0 * width], & p01 = frame.data[x1 + y0 * width];
+        const auto& p10 = frame.data[x0 + y1 * width], & p11 = frame.data[x1 + y1 * width];
+
+        // Sums of four, hence the additional shift by two. Pure blue and red round up to 256, hence the clamp.
+        const std::int32_t r = p00[0] + p01[0] + p10[0] + p11[0];
+        const std::int32_t g = p00[1] + p01[1] + p10[1] + p11[1];
+        const std::int32_t b = p00[2] + p01[2] + p10[2] + p11[2];
+
+        const auto index = static_cast<std::size_t>(x) + static_cast<std::size_t>(y) * chroma_width;
+        cb_plane[index] = static_cast<std::uint8_t>(std::min((-11059 * r - 21709 * g + 32768 * b + (128 << 18) + (1 << 17)) >> 18, 255));
+        cr_plane[index] = static_cast<std::uint8_t>(std::min(( 32768 * r - 27439 * g -  5329 * b + (128 << 18) + (1 << 17)) >> 18, 255));
+      }
+    }
+  }
+  void write  (const void* data, const std::size_t size)
+  {
+    if (std::fwrite(data, 1, size, file_) != size)
+      throw std::runtime_error("Failed fwrite.");
+  }
+
+  std::FILE*                file_   = nullptr;
+  vector2<std::int32_t>     size_   ;
+  raw_video_format          format_ ;
+  std::vector<std::uint8_t> buffer_ ;
+};
+}
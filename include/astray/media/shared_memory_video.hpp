@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include <astray/math/linear_algebra.hpp>
+#include <astray/media/image.hpp>
+#include <astray/utility/shared_memory.hpp>
+
+namespace ast
+{
+// The layout of the shared memory of shared_memory_video: a header followed by slot_count slots, each consisting of a
+// slot header and the pixels of a frame. Frame i is published into slot i % slot_count.
+namespace shared_memory_video_layout
+{
+struct header
+{
+  char                       magic      [8] = {'A', 'S', 'T', 'R', 'A', 'Y', 'R', 'B'};
+  std::uint32_t              version        = 1;
+  std::uint32_t              slot_count     = 0;
+  std::int32_t               size       [2] = {0, 0};
+  std::uint64_t              slot_stride    = 0;
+  std::atomic<std::uint64_t> published      {0}; // Number of published frames.
+  std::atomic<std::uint64_t> read           {0}; // One past the index of the last frame read.
+  std::atomic<std::uint64_t> dropped        {0}; // Number of frames overwritten before being read.
+};
+// Sequence lock: odd while the writer updates the slot. Readers validate that it is even and unchanged after reading.
+struct slot_header
+{
+  std::atomic<std::uint64_t> sequence       {0};
+  std::uint64_t              frame_index    = 0;
+  std::int64_t               timestamp      = 0; // Nanoseconds since the epoch of the system clock.
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Shared memory synchronization requires lock-free atomics.");
+
+constexpr std::size_t align(const std::size_t size, const std::size_t alignment = 64)
+{
+  return (size + alignment - 1) / alignment * alignment;
+}
+}
+
+// Publishes frames into a ring buffer in POSIX shared memory, for live viewers in other processes. Publishing never
+// blocks: if the readers fall behind, the oldest slot is overwritten and the frame is counted as dropped.
+class shared_memory_video
+{
+public:
+  using image_type  = image<vector3<std::uint8_t>>;
+  using header      = shared_memory_video_layout::header;
+  using slot_header = shared_memory_video_layout::slot_header;
+
+  explicit shared_memory_video  (
+    const std::string&           name       = "/astray",
+    const vector2<std::int32_t>& size       = vector2<std::int32_t>(1920, 1080),
+    const std::size_t            slot_count = 4)
+  : size_       (size)
+  , slot_count_ (slot_count)
+  , slot_stride_(shared_memory_video_layout::align(sizeof(slot_header) + size.prod() * sizeof(vector3<std::uint8_t>)))
+  , memory_     (name, shared_memory_video_layout::align(sizeof(header)) + slot_count * slot_stride_)
+  {
+    if (slot_count == 0)
+      throw std::runtime_error("At least one slot is required.");
+
+    auto* shared_header        = new (memory_.data()) header;
+    shared_header->slot_count  = static_cast<std::uint32_t>(slot_count_);
+    shared_header->size[0]     = size[0];
+    shared_header->size[1]     = size[1];
+    shared_header->slot_stride = slot_stride_;
+    for (std::size_t i = 0; i < slot_count_; ++i)
+      new (slot(i)) slot_header;
+  }
+  shared_memory_video           (const shared_memory_video&  that) = delete;
+  shared_memory_video           (      shared_memory_video&& temp) = default;
+  virtual ~shared_memory_video  ()                                 = default;
+  shared_memory_video& operator=(const shared_memory_video&  that) = delete;
+  shared_memory_video& operator=(      shared_memory_video&& temp) = default;
+
+  void          append                 (const image_type& frame)
+  {
+    if (frame.size != size_)
+      throw std::runtime_error("Frame size does not match the video size.");
+
+    auto*      shared_header = reinterpret_cast<header*>(memory_.data());
+    const auto frame_index   = shared_header->published.load(std::memory_order_relaxed);
+    if (frame_index >= slot_count_ && shared_header->read.load(std::memory_order_relaxed) <= frame_index - slot_count_)
+      shared_header->dropped.fetch_add(1, std::memory_order_relaxed); // The frame in the slot was never read.
+
+    auto*      target        = slot(frame_index % slot_count_);
+    const auto sequence      = target->sequence.load(std::memory_order_relaxed);
+    target->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    target->frame_index      = frame_index;
+    target->timestamp        = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::memcpy(reinterpret_cast<std::uint8_t*>(target) + sizeof(slot_header), frame.data.data(), frame.data.size() * sizeof(vector3<std::uint8_t>));
+
+    target->sequence.store(sequence + 2, std::memory_order_release);
+    shared_header->published.store(frame_index + 1, std::memory_order_release);
+  }
+
+  std::uint64_t get_dropped_frame_count() const
+  {
+    return reinterpret_cast<const header*>(memory_.data())->dropped.load(std::memory_order_relaxed);
+  }
+
+protected:
+  slot_header*  slot                   (const std::size_t index)
+  {
+    return reinterpret_cast<slot_header*>(memory_.data() + shared_memory_video_layout::align(sizeof(header)) + index * slot_stride_);
+  }
+
+  vector2<std::int32_t> size_       ;
+  std::size_t           slot_count_ ;
+  std::size_t           slot_stride_;
+  shared_memory         memory_     ;
+};
+
+// Reads the most recently published frames of a shared_memory_video in another process.
+class shared_memory_video_reader
+{
+public:
+  using image_type  = image<vector3<std::uint8_t>>;
+  using header      = shared_memory_video_layout::header;
+  using slot_header = shared_memory_video_layout::slot_header;
+
+  explicit shared_memory_video_reader  (const std::string& name = "/astray") : memory_(name)
+  {
+    if (memory_.size() < sizeof(header))
+      throw std::runtime_error("Invalid shared memory video!");
+
+    const auto* shared_header = reinterpret_cast<const header*>(memory_.data());
+    if (std::memcmp(shared_header->magic, header().magic, sizeof(header::magic)) != 0 || shared_header->version != header().version)
+      throw std::runtime_error("Invalid shared memory video!");
+
+    // The layout is validated against the mapping once and retained, hence a mismatching or altered segment can not
+    // redirect the reads out of bounds.
+    size_        = vector2<std::int32_t>(shared_header->size[0], shared_header->size[1]);
+    slot_count_  = shared_header->slot_count;
+    slot_stride_ = shared_header->slot_stride;
+
+    const auto slots_offset = shared_memory_video_layout::align(sizeof(header));
+    const auto slots_size   = memory_.size() >= slots_offset ? memory_.size() - slots_offset : 0;
+    const auto frame_size   = static_cast<std::uint64_t>(std::max(size_[0], 0)) * static_cast<std::uint64_t>(std::max(size_[1], 0)) * sizeof(vector3<std::uint8_t>);
+    if (size_[0] <= 0 || size_[1] <= 0 || slot_count_ == 0 ||
+        slot_stride_ < sizeof(slot_header) || slot_stride_ - sizeof(slot_header) < frame_size ||
+        slot_stride_ > slots_size || slot_count_ > slots_size / slot_stride_)
+      throw std::runtime_error("Invalid shared memory video!");
+  }
+  shared_memory_video_reader           (const shared_memory_video_reader&  that) = delete;
+  shared_memory_video_reader           (      shared_memory_video_reader&& temp) = default;
+  virtual ~shared_memory_video_reader  ()                                        = default;
+  shared_memory_video_reader& operator=(const shared_memory_video_reader&  that) = delete;
+  shared_memory_video_reader& operator=(      shared_memory_video_reader&& temp) = default;
+
+  vector2<std::int32_t> get_size     () const
+  {
+    return size_;
+  }
+
+  // Calls function(pixels, frame_index, timestamp) on the latest frame in place, without copying it. Returns false if
+  // there is no new frame, or if the writer overwrote the slot meanwhile, in which case the results must be discarded.
+  template <typename function_type>
+  bool                  read_in_place(function_type&& function)
+  {
+    auto*      shared_header = reinterpret_cast<header*>(memory_.data());
+    const auto published     = shared_header->published.load(std::memory_order_acquire);
+    if (published == 0 || published <= shared_header->read.load(std::memory_order_relaxed))
+      return false;
+
+    const auto  frame_index = published - 1;
+    const auto* source      = reinterpret_cast<const slot_header*>(memory_.data() + shared_memory_video_layout::align(sizeof(header)) + (frame_index % slot_count_) * slot_stride_);
+    const auto  sequence    = source->sequence.load(std::memory_order_acquire);
+    if (sequence & 1 || source->frame_index != frame_index)
+      return false;
+
+    function(reinterpret_cast<const vector3<std::uint8_t>*>(reinterpret_cast<const std::uint8_t*>(source) + sizeof(slot_header)), source->frame_index, source->timestamp);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (source->sequence.load(std::memory_order_relaxed) != sequence)
+      return false;
+
+    shared_header->read.store(frame_index + 1, std::memory_order_relaxed);
+    return true;
+  }
+  // Copies the latest frame into the given image, resizing it if necessary.
+  bool                  read         (image_type& frame, std::uint64_t* frame_index = nullptr)
+  {
+    const auto size = get_size();
+    if (frame.size != size)
+      frame = image_type(size);
+
+    return read_in_place([&] (const vector3<std::uint8_t>* pixels, const std::uint64_t index, std::int64_t)
+    {
+      std::memcpy(frame.data.data(), pixels, frame.data.size() * sizeof(vector3<std::uint8_t>));
+      if (frame_index)
+        *frame_index = index;
+    });
+  }
+
+protected:
+  shared_memory         memory_      ;
+  vector2<std::int32_t> size_        ;
+  std::uint64_t         slot_count_  = 0;
+  std::uint64_t         slot_stride_ = 0;
+};
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <astray/math/linear_algebra.hpp>
+#include <astray/media/image.hpp>
+#include <astray/media/mapped_image.hpp>
+
+namespace ast
+{
+enum class tiled_image_format
+{
+  raw, // The raw format of mapped_image. Tiles are written in place, in any order.
+  png  // Uncompressed (stored deflate) PNG. Rows are written in order, tiles have to arrive stripe by stripe.
+};
+
+// Writes an image tile by tile without ever holding it in memory, e.g. the tiles of ray_tracer::render_tiles. The raw
+// format holds no pixels in memory, the PNG format buffers a single stripe of rows until all its tiles have arrived.
+class tiled_image_writer
+{
+public:
+  using pixel_type = vector3<std::uint8_t>;
+  using image_type = image<pixel_type>;
+  using size_type  = image_type::size_type;
+
+  explicit tiled_image_writer  (const std::filesystem::path& filepath, const size_type& size, const tiled_image_format format = tiled_image_format::raw)
+  : size_(size), format_(format)
+  {
+    if (size[0] <= 0 || size[1] <= 0)
+      throw std::runtime_error("Cannot write an empty image.");
+
+    file_ = std::fopen(filepath.string().c_str(), "wb");
+    if (!file_)
+      throw std::runtime_error("Failed fopen.");
+
+    if (format_ == tiled_image_format::raw)
+    {
+      mapped_image<pixel_type>::header header;
+      header.size[0] = size[0];
+      header.size[1] = size[1];
+      write(&header, sizeof(header));
+
+      // Extends the file to its final size, so that it is a valid mapped image regardless of the order of the tiles.
+      seek(sizeof(header) + static_cast<std::uint64_t>(size.prod()) * sizeof(pixel_type) - 1);
+      write("", 1);
+    }
+    else
+    {
+      constexpr std::uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+      write(signature, sizeof(signature));
+
+      std::vector<std::uint8_t> header;
+      append_big_endian(header, static_cast<std::uint32_t>(size[0]));
+      append_big_endian(header, static_cast<std::uint32_t>(size[1]));
+      header.insert(header.end(), {8, 2, 0, 0, 0}); // 8-bit RGB, deflate, adaptive filtering, no interlacing.
+      write_chunk("IHDR", header);
+
+      const std::vector<std::uint8_t> zlib_header {0x78, 0x01};
+      write_chunk("IDAT", zlib_header);
+    }
+  }
+  tiled_image_writer           (const tiled_image_writer&  that) = delete;
+  tiled_image_writer           (      tiled_image_writer&& temp) = delete;
+  virtual ~tiled_image_writer  ()
+  {
+    try
+    {
+      close();
+    }
+    catch (...)
+    {
+
+    }
+  }
+  tiled_image_writer& operator=(const tiled_image_writer&  that) = delete;
+  tiled_image_writer& operator=(      tiled_image_writer&& temp) = delete;
+
+  void write (const image_type& tile, const size_type& offset)
+  {
+    if (!file_)
+      throw std::runtime_error("The image is closed.");
+    if ((offset.array() < 0).any() || ((offset + tile.size).array() > size_.array()).any())
+      throw std::runtime_error("Tile is out of the image bounds.");
+
+    if (format_ == tiled_image_format::raw)
+    {
+      const auto row_size = static_cast<std::size_t>(tile.size[0]) * sizeof(pixel_type);
+      for (auto y = 0; y < tile.size[1]; ++y)
+      {
+        seek(sizeof(mapped_image<pixel_type>::header) + (static_cast<std::uint64_t>(offset[1] + y) * size_[0] + offset[0]) * sizeof(pixel_type));
+        write(tile.data.data() + static_cast<std::size_t>(y) * tile.size[0], row_size);
+      }
+      return;
+    }
+
+    // The stripe begins at the next unwritten row and is as high as its first tile.
+    if (stripe_pixels_ == 0)
+    {
+      stripe_.resize(static_cast<std::size_t>(size_[0]) * tile.size[1]);
+      stripe_height_ = tile.size[1];
+    }
+    if (offset[1] != next_row_ || tile.size[1] != stripe_height_)
+      throw std::runtime_error("PNG tiles have to arrive stripe by stripe, top to bottom.");
+
+    for (auto y = 0; y < tile.size[1]; ++y)
+      std::copy_n(tile.data.begin() + static_cast<std::size_t>(y) * tile.size[0], tile.size[0], stripe_.begin() + static_cast<std::size_t>(y) * size_[0] + offset[0]);
+    stripe_pixels_ += static_cast<std::size_t>(tile.size.prod());
+
+    if (stripe_pixels_ == stripe_.size())
+    {
+      for (auto y = 0; y < stripe_height_; ++y)
+        write_row(stripe_.data() + static_cast<std::size_t>(y) * size_[0]);
+      next_row_     += stripe_height_;
+      stripe_pixels_ = 0;
+    }
+  }
+  // Completes the file. Called by the destructor, call explicitly to observe errors.
+  void close ()
+  {
+    if (!file_)
+      return;
+
+    if (format_ == tiled_image_format::png)
+    {
+      if (next_row_ != size_[1])
+        throw std::runtime_error("The PNG is incomplete.");
+
+      std::vector<std::uint8_t> trailer {1, 0, 0, 0xFF, 0xFF}; // An empty final stored block.
+      append_big_endian(trailer, (adler_b_ << 16) | adler_a_);
+      write_chunk("IDAT", trailer);
+      write_chunk("IEND", {});
+    }
+
+    const auto result = std::fclose(file_);
+    file_ = nullptr;
+    if (result != 0)
+      throw std::runtime_error("Failed fclose.");
+  }
+
+protected:
+  // Each row is a separate (non-final) stored deflate block in its own IDAT chunk, hence rows up to ~21k pixels wide fit
+  // the 65535 byte limit of stored blocks. Wider rows are split into several blocks.
+  void write_row (const pixel_type* row)
+  {
+    const auto row_size = 1 + static_cast<std::size_t>(size_[0]) * sizeof(pixel_type);
+    row_buffer_.resize(row_size);
+    row_buffer_[0] = 0; // No filter.
+    std::copy_n(reinterpret_cast<const std::uint8_t*>(row), row_size - 1, row_buffer_.begin() + 1);
+
+    for (const auto byte : row_buffer_)
+    {
+      adler_a_ = (adler_a_ + byte    ) % 65521;
+      adler_b_ = (adler_b_ + adler_a_) % 65521;
+    }
+
+    std::vector<std::uint8_t> block;
+    for (std::size_t begin = 0; begin < row_size; begin += 65535)
+    {
+      const auto length = static_cast<std::uint16_t>(std::min<std::size_t>(65535, row_size - begin));
+      block.clear();
+      block.insert(block.end(), {0, static_cast<std::uint8_t>(length & 0xFF), static_cast<std::uint8_t>(length >> 8), static_cast<std::uint8_t>(~length & 0xFF), static_cast<std::uint8_t>((~length >> 8) & 0xFF)});
+      block.insert(block.end(), row_buffer_.begin() + begin, row_buffer_.begin() + begin + length);
+      write_chunk("IDAT", block);
+    }
+  }
+  void write_chunk(const char* type, const std::vector<std::uint8_t>& data)
+  {
+    std::vector<std::uint8_t> chunk;
+    chunk.reserve(data.size() + 12);
+    append_big_endian(chunk, static_cast<std::uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    append_big_endian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    write(chunk.data(), chunk.size());
+  }
+  void write      (const void* data, const std::size_t size)
+  {
+    if (std::fwrite(data, 1, size, file_) != size)
+      throw std::runtime_error("Failed fwrite.");
+  }
+  void seek       (const std::uint64_t position)
+  {
+#ifdef _WIN32
+    const auto result = _fseeki64(file_, static_cast<__int64>(position), SEEK_SET);
+#else
+    const auto result = fseeko   (file_, static_cast<off_t  >(position), SEEK_SET);
+#endif
+    if (result != 0)
+      throw std::runtime_error("Failed fseek.");
+  }
+
+  static void          append_big_endian(std::vector<std::uint8_t>& target, const std::uint32_t value)
+  {
+    target.insert(target.end(), {
+      static_cast<std::uint8_t>(value >> 24),
+      static_cast<std::uint8_t>(value >> 16),
+      static_cast<std::uint8_t>(value >>  8),
+      static_cast<std::uint8_t>(value      )});
+  }
+  static std::uint32_t crc32            (const std::uint8_t* data, const std::size_t size)
+  {
+    static const auto table = []
+    {
+      std::array<std::uint32_t, 256> result {};
+      for (std::uint32_t i = 0; i < 256; ++i)
+      {
+        auto value = i;
+        for (auto j = 0; j < 8; ++j)
+          value = value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+        result[i] = value;
+      }
+      return result;
+    }();
+
+    std::uint32_t value = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < size; ++i)
+      value = table[(value ^ data[i]) & 0xFF] ^ (value >> 8);
+    return value ^ 0xFFFFFFFFu;
+  }
+
+  size_type                 size_         ;
+  tiled_image_format        format_       ;
+  std::FILE*                file_         = nullptr;
+
+  std::vector<pixel_type>   stripe_       ;
+  std::int32_t              stripe_height_= 0;
+  std::size_t               stripe_pixels_= 0;
+  std::int32_t              next_row_     = 0;
+  std::vector<std::uint8_t> row_buffer_   ;
+  std::uint32_t             adler_a_      = 1;
+  std::uint32_t             adler_b_      = 0;
+};
+}
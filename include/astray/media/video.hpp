@@ -1,10 +1,19 @@
 #pragma once
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <exception>
 #include <filesystem>
+#include <mutex>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #ifdef ASTRAY_USE_FFMPEG
 extern "C"
@@ -18,160 +27,345 @@ extern "C"
 
 #include <astray/math/linear_algebra.hpp>
 #include <astray/media/image.hpp>
-#include <astray/utility/warning.hpp>
-
-DISABLE_WARNING_PUSH
-DISABLE_WARNING_PRAGMAS
-DISABLE_WARNING_NO_DEPRECATED
 
 namespace ast
 {
+// Frames are color converted and encoded on a dedicated thread. The appended frames are queued, and append only blocks
+// while the queue is full. The queue is flushed on destruction.
 class video
 {
 public:
+  using image_type = image<vector3<std::uint8_t>>;
+
+  // The preset and the constant rate factor apply to encoders supporting them (e.g. libx264, libx265), a thread count of
+  // zero uses all hardware threads for both the color conversion and the encoder.
   explicit video  (
-    const std::filesystem::path&      filepath   , 
-    const vector2<std::int32_t>&      size       = vector2<std::int32_t>(1920, 1080),
-    const std::int32_t                frame_rate = 30, 
-    const std::int64_t                bit_rate   = 10000000,
-    const std::optional<std::string>& codec_name = std::nullopt)
+    const std::filesystem::path&      filepath       ,
+    const vector2<std::int32_t>&      size           = vector2<std::int32_t>(1920, 1080),
+    const std::int32_t                frame_rate     = 30,
+    const std::int64_t                bit_rate       = 10000000,
+    const std::optional<std::string>& codec_name     = std::nullopt,
+    const std::string&                preset         = "slow",
+    const std::int32_t                crf            = 20,
+    const std::size_t                 thread_count   = 0,
+    const std::size_t                 queue_capacity = 8)
+  : queue_capacity_(queue_capacity)
   {
+    // The destructor does not run if the constructor throws, hence the objects created so far are released here.
+    try
+    {
 #ifdef ASTRAY_USE_FFMPEG
-    av_register_all();
-
-    output_format_ = av_guess_format(nullptr, filepath.string().c_str(), nullptr);
-    if (!output_format_) 
-      throw std::runtime_error("Failed av_guess_format.");
-
-    if(avformat_alloc_output_context2(&format_context_, output_format_, nullptr, nullptr) < 0)
-      throw std::runtime_error("Failed avformat_alloc_output_context2.");
-
-    auto* codec = avcodec_find_encoder(output_format_->video_codec);
-    if (codec_name)
-      codec = avcodec_find_encoder_by_name(codec_name.value().c_str());
-    if (!codec)
-      throw std::runtime_error("Failed avcodec_find_encoder.");
-
-    stream_ = avformat_new_stream(format_context_, codec);
-    if (!stream_)
-      throw std::runtime_error("Failed avformat_new_stream.");
-
-    codec_context_            = stream_->codec;
-    codec_context_->width     = size[0];
-    codec_context_->height    = size[1];
-    codec_context_->pix_fmt   = AV_PIX_FMT_YUV420P;
-    codec_context_->time_base = AVRational {1, frame_rate};
-    codec_context_->bit_rate  = bit_rate;
-    if (format_context_->oformat->flags & AVFMT_GLOBALHEADER)
-      codec_context_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
-
-    AVDictionary* codec_options = nullptr;
-    av_dict_set(&codec_options, "preset", "slow", 0);
-    av_dict_set(&codec_options, "crf"   , "20"  , 0);
-    if (avcodec_open2(codec_context_, codec, &codec_options) < 0)
-      throw std::runtime_error("Failed avcodec_open2.");
-    av_dict_free(&codec_options);
-
-    stream_->time_base = codec_context_->time_base;
-    av_dump_format(format_context_, 0, filepath.string().c_str(), 1);
-    if (!(output_format_->flags & AVFMT_NOFILE) && avio_open(&format_context_->pb, filepath.string().c_str(), AVIO_FLAG_WRITE) < 0)
-      throw std::runtime_error("Failed avio_open.");
-
-    if (avformat_write_header(format_context_, nullptr) < 0)
-      throw std::runtime_error("Failed avformat_write_header.");
-
-    frame_         = av_frame_alloc();
-    frame_->format = AV_PIX_FMT_YUV420P;
-    frame_->width  = codec_context_->width;
-    frame_->height = codec_context_->height;
-    if (av_frame_get_buffer(frame_, 0) < 0)
-      throw std::runtime_error("Failed av_frame_get_buffer.");
-
-    sws_context_ = sws_getContext(size[0], size[1], AV_PIX_FMT_RGB24, size[0], size[1], AV_PIX_FMT_YUV420P, SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
-    if (!sws_context_)
-      throw std::runtime_error("Failed sws_getContext.");
+      const auto threads = thread_count > 0 ? thread_count : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+      if (avformat_alloc_output_context2(&format_context_, nullptr, nullptr, filepath.string().c_str()) < 0)
+        throw std::runtime_error("Failed avformat_alloc_output_context2.");
+
+      const auto* codec = codec_name
+        ? avcodec_find_encoder_by_name(codec_name.value().c_str())
+        : avcodec_find_encoder        (format_context_->oformat->video_codec);
+      if (!codec)
+        throw std::runtime_error("Failed avcodec_find_encoder.");
+
+      stream_ = avformat_new_stream(format_context_, nullptr);
+      if (!stream_)
+        throw std::runtime_error("Failed avformat_new_stream.");
+
+      codec_context_ = avcodec_alloc_context3(codec);
+      if (!codec_context_)
+        throw std::runtime_error("Failed avcodec_alloc_context3.");
+
+      codec_context_->width        = size[0];
+      codec_context_->height       = size[1];
+      codec_context_->pix_fmt      = AV_PIX_FMT_YUV420P;
+      codec_context_->time_base    = AVRational {1, frame_rate};
+      codec_context_->framerate    = AVRational {frame_rate, 1};
+      codec_context_->bit_rate     = bit_rate;
+      codec_context_->thread_count = static_cast<std::int32_t>(threads);
+      codec_context_->thread_type  = FF_THREAD_FRAME | FF_THREAD_SLICE;
+      if (format_context_->oformat->flags & AVFMT_GLOBALHEADER)
+        codec_context_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+      AVDictionary* codec_options = nullptr;
+      av_dict_set    (&codec_options, "preset", preset.c_str(), 0);
+      av_dict_set_int(&codec_options, "crf"   , crf           , 0);
+      const auto opened = avcodec_open2(codec_context_, codec, &codec_options);
+      av_dict_free(&codec_options);
+      if (opened < 0)
+        throw std::runtime_error("Failed avcodec_open2.");
+
+      if (avcodec_parameters_from_context(stream_->codecpar, codec_context_) < 0)
+        throw std::runtime_error("Failed avcodec_parameters_from_context.");
+      stream_->time_base = codec_context_->time_base;
+
+      av_dump_format(format_context_, 0, filepath.string().c_str(), 1);
+      if (!(format_context_->oformat->flags & AVFMT_NOFILE) && avio_open(&format_context_->pb, filepath.string().c_str(), AVIO_FLAG_WRITE) < 0)
+        throw std::runtime_error("Failed avio_open.");
+
+      if (avformat_write_header(format_context_, nullptr) < 0)
+        throw std::runtime_error("Failed avformat_write_header.");
+
+      frame_         = av_frame_alloc();
+      if (!frame_)
+        throw std::runtime_error("Failed av_frame_alloc.");
+      frame_->format = AV_PIX_FMT_YUV420P;
+      frame_->width  = codec_context_->width;
+      frame_->height = codec_context_->height;
+      if (av_frame_get_buffer(frame_, 0) < 0)
+        throw std::runtime_error("Failed av_frame_get_buffer.");
+
+      packet_ = av_packet_alloc();
+      if (!packet_)
+        throw std::runtime_error("Failed av_packet_alloc.");
+
+      // The color conversion is split into bands of rows, each with its own context. The bands start at even rows, so that
+      // the chroma planes of 4:2:0 are split at the same boundaries.
+      const auto band_count  = std::clamp<std::int32_t>(static_cast<std::int32_t>(threads), 1, std::max(size[1] / 16, 1));
+      const auto band_height = ((size[1] + band_count - 1) / band_count + 1) & ~1;
+      for (auto offset = 0; offset < size[1]; offset += band_height)
+      {
+        const auto height = std::min(band_height, size[1] - offset);
+        auto&      band   = sws_bands_.emplace_back(sws_band {nullptr, offset, height}); // Owned before it is created.
+        band.context      = sws_getContext(size[0], height, AV_PIX_FMT_RGB24, size[0], height, AV_PIX_FMT_YUV420P, SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+        if (!band.context)
+          throw std::runtime_error("Failed sws_getContext.");
+      }
+      // The first band is converted by the encoder thread, the others by persistent workers.
+      for (std::size_t i = 1; i < sws_bands_.size(); ++i)
+        band_workers_.emplace_back(&video::convert_bands, this, i);
 #endif
+
+      encoder_ = std::thread(&video::encode_queue, this);
+    }
+    catch (...)
+    {
+      release();
+      throw;
+    }
   }
-  video           (const video&  that) = delete ;
-  video           (      video&& temp) = default;
+  video           (const video&  that) = delete;
+  video           (      video&& temp) = delete; // The encoder and band threads refer to this instance.
   virtual ~video  ()
   {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    not_empty_.notify_one();
+    encoder_  .join      ();
+
 #ifdef ASTRAY_USE_FFMPEG
-    // Receive delayed frames.
-    AVPacket packet;
-    av_init_packet(&packet);
-    packet.data = nullptr;
-    packet.size = 0;
-
-    auto received = 1;
-    while (received)
+    try
     {
-      avcodec_encode_video2(codec_context_, &packet, nullptr, &received);
-      if (received)
-      {
-        std::fflush(stdout);
-        av_packet_rescale_ts(&packet, codec_context_->time_base, stream_->time_base);
-        packet.stream_index = stream_->index;
-        av_interleaved_write_frame(format_context_, &packet);
-        av_packet_unref(&packet);
-      }
+      // Receive delayed frames.
+      avcodec_send_frame(codec_context_, nullptr);
+      write_packets();
+    }
+    catch (...)
+    {
+
     }
 
     av_write_trailer(format_context_);
+#endif
+    release();
+  }
+  video& operator=(const video&  that) = delete;
+  video& operator=(      video&& temp) = delete;
 
-    if (!(output_format_->flags & AVFMT_NOFILE))
-      avio_closep(&format_context_->pb);
-    avcodec_close(stream_->codec);
+  // Takes ownership of the frame (move it in to avoid the copy) and returns immediately, unless the queue is full. Errors
+  // of the encoder thread are rethrown here.
+  void append(image_type frame)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_full_.wait(lock, [&] { return queue_.size() < queue_capacity_ || exception_; });
+      if (exception_)
+        std::rethrow_exception(exception_);
+      queue_.push(std::move(frame));
+    }
+    not_empty_.notify_one();
+  }
 
-    sws_freeContext      (sws_context_   );
-    avformat_free_context(format_context_);
-    av_frame_free        (&frame_        );
+protected:
+#ifdef ASTRAY_USE_FFMPEG
+  struct sws_band
+  {
+    SwsContext*  context;
+    std::int32_t offset ;
+    std::int32_t height ;
+  };
 #endif
-  }
-  video& operator=(const video&  that) = delete ;
-  video& operator=(      video&& temp) = default;
 
-  void append(image<vector3<std::uint8_t>>& frame)
+  void encode_queue ()
+  {
+    while (true)
+    {
+      image_type frame;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&] { return !queue_.empty() || done_; });
+        if (queue_.empty())
+          return; // Done and drained.
+        frame = std::move(queue_.front());
+        queue_.pop();
+      }
+      not_full_.notify_one();
+
+      try
+      {
+        encode(frame);
+      }
+      catch (...)
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          exception_ = std::current_exception();
+        }
+        not_full_.notify_all();
+        return;
+      }
+    }
+  }
+  void encode       (image_type& frame)
   {
 #ifdef ASTRAY_USE_FFMPEG
-    std::uint8_t*      data     [8] {&frame.data[0][0]};
-    const std::int32_t line_size[8] {static_cast<std::int32_t>(frame.size[0] * sizeof(vector3<std::uint8_t>))};
-    sws_scale(sws_context_, data, line_size, 0, frame.size[1], frame_->data, frame_->linesize);
+    if (frame.size[0] != frame_->width || frame.size[1] != frame_->height)
+      throw std::runtime_error("Frame size does not match the video size.");
+    if (av_frame_make_writable(frame_) < 0) // The encoder may still reference the previous frame.
+      throw std::runtime_error("Failed av_frame_make_writable.");
 
-    AVPacket packet;
-    av_init_packet(&packet);
-    packet.data = nullptr;
-    packet.size = 0;
+    {
+      std::lock_guard<std::mutex> lock(band_mutex_);
+      band_frame_    = &frame;
+      band_pending_  = sws_bands_.size() - 1;
+      ++band_generation_;
+    }
+    band_started_.notify_all();
+    convert_band(frame, sws_bands_[0]);
+    {
+      std::unique_lock<std::mutex> lock(band_mutex_);
+      band_finished_.wait(lock, [&] { return band_pending_ == 0; });
+    }
 
     frame_->pts = frame_count_++;
 
-    auto received = 1;
-    if (avcodec_encode_video2(codec_context_, &packet, frame_, &received) < 0)
-      throw std::runtime_error("Failed avcodec_encode_video2.");
-    if (received)
+    if (avcodec_send_frame(codec_context_, frame_) < 0)
+      throw std::runtime_error("Failed avcodec_send_frame.");
+    write_packets();
+#endif
+  }
+#ifdef ASTRAY_USE_FFMPEG
+  void convert_band (const image_type& frame, const sws_band& band)
+  {
+    const std::uint8_t* source       [1] {&frame.data[band.offset * frame.size[0]][0]};
+    const std::int32_t  source_stride[1] {static_cast<std::int32_t>(frame.size[0] * sizeof(vector3<std::uint8_t>))};
+    std::uint8_t*       target       [3]
+    {
+      frame_->data[0] + band.offset     * frame_->linesize[0],
+      frame_->data[1] + band.offset / 2 * frame_->linesize[1],
+      frame_->data[2] + band.offset / 2 * frame_->linesize[2]
+    };
+    sws_scale(band.context, source, source_stride, 0, band.height, target, frame_->linesize);
+  }
+  // Converts the band of the given index of each frame which encode hands out, until the video is destroyed.
+  void convert_bands(const std::size_t index)
+  {
+    std::uint64_t generation = 0;
+    while (true)
     {
-      std::fflush(stdout);
-      av_packet_rescale_ts(&packet, codec_context_->time_base, stream_->time_base);
-      packet.stream_index = stream_->index;
+      const image_type* frame;
+      {
+        std::unique_lock<std::mutex> lock(band_mutex_);
+        band_started_.wait(lock, [&] { return band_generation_ != generation || band_done_; });
+        if (band_done_)
+          return;
+        generation = band_generation_;
+        frame      = band_frame_;
+      }
+
+      convert_band(*frame, sws_bands_[index]);
 
-      if (av_interleaved_write_frame(format_context_, &packet) < 0)
+      {
+        std::lock_guard<std::mutex> lock(band_mutex_);
+        --band_pending_;
+      }
+      band_finished_.notify_one();
+    }
+  }
+#endif
+  // Stops the band workers and frees the FFmpeg objects. Also releases a partially constructed video, hence tolerates
+  // the objects which were not created yet.
+  void release      ()
+  {
+#ifdef ASTRAY_USE_FFMPEG
+    {
+      std::lock_guard<std::mutex> lock(band_mutex_);
+      band_done_ = true;
+    }
+    band_started_.notify_all();
+    for (auto& worker : band_workers_)
+      worker.join();
+    band_workers_.clear();
+
+    if (format_context_ && !(format_context_->oformat->flags & AVFMT_NOFILE))
+      avio_closep(&format_context_->pb);
+
+    for (auto& band : sws_bands_)
+      sws_freeContext    (band.context   );
+    sws_bands_.clear();
+    avcodec_free_context (&codec_context_);
+    avformat_free_context(format_context_);
+    av_frame_free        (&frame_        );
+    av_packet_free       (&packet_       );
+    format_context_ = nullptr;
+    stream_         = nullptr;
+#endif
+  }
+  void write_packets()
+  {
+#ifdef ASTRAY_USE_FFMPEG
+    while (true)
+    {
+      const auto received = avcodec_receive_packet(codec_context_, packet_);
+      if (received == AVERROR(EAGAIN) || received == AVERROR_EOF)
+        return;
+      if (received < 0)
+        throw std::runtime_error("Failed avcodec_receive_packet.");
+
+      av_packet_rescale_ts(packet_, codec_context_->time_base, stream_->time_base);
+      packet_->stream_index = stream_->index;
+
+      if (av_interleaved_write_frame(format_context_, packet_) < 0) // Takes ownership of the packet data.
         throw std::runtime_error("Failed av_interleaved_write_frame.");
-      av_packet_unref(&packet);
     }
 #endif
   }
 
-protected:
 #ifdef ASTRAY_USE_FFMPEG
-  AVOutputFormat*  output_format_  = nullptr;
-  AVFormatContext* format_context_ = nullptr;
-  AVCodecContext*  codec_context_  = nullptr;
-  AVStream*        stream_         = nullptr;
-  AVFrame*         frame_          = nullptr;
-  SwsContext*      sws_context_    = nullptr;
+  AVFormatContext*        format_context_ = nullptr;
+  AVCodecContext*         codec_context_  = nullptr;
+  AVStream*               stream_         = nullptr;
+  AVFrame*                frame_          = nullptr;
+  AVPacket*               packet_         = nullptr;
+  std::vector<sws_band>   sws_bands_      ;
+  std::vector<std::thread> band_workers_ ;
+  std::mutex              band_mutex_     ;
+  std::condition_variable band_started_   ;
+  std::condition_variable band_finished_  ;
+  const image_type*       band_frame_     = nullptr;
+  std::uint64_t           band_generation_ = 0;
+  std::size_t             band_pending_   = 0;
+  bool                    band_done_      = false;
 #endif
-  std::int64_t     frame_count_    = 0;
+  std::int64_t            frame_count_    = 0;
+
+  std::size_t             queue_capacity_ ;
+  std::queue<image_type>  queue_          ;
+  std::mutex              mutex_          ;
+  std::condition_variable not_empty_      ;
+  std::condition_variable not_full_       ;
+  std::exception_ptr      exception_      ;
+  bool                    done_           = false;
+  std::thread             encoder_        ;
 };
 }
-
-DISABLE_WARNING_POP
@@ -1,32 +1,111 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 
 #ifdef ASTRAY_USE_MPI
 #include <mpi.h>
 #endif
 
 #include <astray/parallel/mpi/data_type.hpp>
+#include <astray/parallel/mpi/request.hpp>
 
 namespace ast::mpi
 {
+#ifdef ASTRAY_USE_MPI
+constexpr std::int32_t any_source = MPI_ANY_SOURCE;
+constexpr std::int32_t undefined  = MPI_UNDEFINED;
+#else
+constexpr std::int32_t any_source = -1;
+constexpr std::int32_t undefined  = -32766;
+#endif
+
 class communicator
 {
 public:
 #ifdef ASTRAY_USE_MPI
-  explicit communicator  (const std::int32_t native = MPI_COMM_WORLD)
+  explicit communicator  (const std::int32_t native = MPI_COMM_WORLD, const bool managed = false)
 #else
-  explicit communicator  (const std::int32_t native = 0)
+  explicit communicator  (const std::int32_t native = 0             , const bool managed = false)
 #endif
-  : native_(native)
+  : native_(native), managed_(managed)
   {
   
   }
-  communicator           (const communicator&  that) = default;
-  communicator           (      communicator&& temp) = default;
- ~communicator           ()                          = default;
-  communicator& operator=(const communicator&  that) = default;
-  communicator& operator=(      communicator&& temp) = default;
+  communicator           (const communicator&  that)
+  : native_(that.native_), managed_(that.managed_)
+  {
+#ifdef ASTRAY_USE_MPI
+    if (managed_)
+      MPI_Comm_dup(that.native_, &native_);
+#endif
+  }
+  communicator           (      communicator&& temp) noexcept
+  : native_(temp.native_), managed_(temp.managed_)
+  {
+    temp.managed_ = false;
+  }
+  virtual ~communicator  ()
+  {
+    free();
+  }
+  communicator& operator=(const communicator&  that)
+  {
+    if (this != &that)
+    {
+      free();
+      native_  = that.native_ ;
+      managed_ = that.managed_;
+#ifdef ASTRAY_USE_MPI
+      if (managed_)
+        MPI_Comm_dup(that.native_, &native_);
+#endif
+    }
+    return *this;
+  }
+  communicator& operator=(      communicator&& temp) noexcept
+  {
+    if (this != &temp)
+    {
+      free();
+      native_       = temp.native_ ;
+      managed_      = temp.managed_;
+      temp.managed_ = false;
+    }
+    return *this;
+  }
+
+  // Splits the communicator into one communicator per color, ordered by key. The ranks of the undefined color receive
+  // a null communicator which must not be used.
+  communicator           split       (const std::int32_t color, const std::int32_t key) const
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Comm result;
+    MPI_Comm_split(native_, color, key, &result);
+    return communicator(result, result != MPI_COMM_NULL);
+#else
+    return communicator(native_);
+#endif
+  }
+  // Splits the communicator into the ranks which are able to share memory, i.e. the ranks on the same node, ordered by
+  // their rank in this communicator.
+  communicator           split_shared() const
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Comm result;
+    MPI_Comm_split_type(native_, MPI_COMM_TYPE_SHARED, rank(), MPI_INFO_NULL, &result);
+    return communicator(result, true);
+#else
+    return communicator(native_);
+#endif
+  }
+
+  void                   barrier() const
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Barrier(native_);
+#endif
+  }
   
   template <typename type>
   void                   bcast  (type* data, std::int32_t size, const data_type& data_type, const std::int32_t root = 0)
@@ -36,6 +115,16 @@ public:
 #endif
   }
   
+  template <typename type>
+  void                   gather (
+    type* sent    , std::int32_t sent_size    , const data_type& sent_data_type    ,
+    type* received, std::int32_t received_size, const data_type& received_data_type, const std::int32_t root = 0)
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Gather(sent, sent_size, sent_data_type.native(), received, received_size, received_data_type.native(), root, native_);
+#endif
+  }
+
   template <typename type>
   void                   gatherv(
     type* sent    , std::int32_t  sent_size     ,                              const data_type& sent_data_type    ,
@@ -46,6 +135,81 @@ public:
 #endif
   }
 
+  // The buffers, sizes and displacements have to remain valid until the request is complete.
+  template <typename type>
+  request                igatherv(
+    type* sent    , std::int32_t  sent_size     ,                              const data_type& sent_data_type    ,
+    type* received, std::int32_t* received_sizes, std::int32_t* displacements, const data_type& received_data_type, const std::int32_t root = 0)
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Request result;
+    MPI_Igatherv(sent, sent_size, sent_data_type.native(), received, received_sizes, displacements, received_data_type.native(), root, native_, &result);
+    return request(result);
+#else
+    return request();
+#endif
+  }
+
+  template <typename type>
+  void                   send   (const type* data, std::int32_t size, const data_type& data_type, const std::int32_t destination, const std::int32_t tag = 0)
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Send(data, size, data_type.native(), destination, tag, native_);
+#endif
+  }
+  template <typename type>
+  request                isend  (const type* data, std::int32_t size, const data_type& data_type, const std::int32_t destination, const std::int32_t tag = 0)
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Request result;
+    MPI_Isend(data, size, data_type.native(), destination, tag, native_, &result);
+    return request(result);
+#else
+    return request();
+#endif
+  }
+  template <typename type>
+  void                   recv   (type* data, std::int32_t size, const data_type& data_type, const std::int32_t source, const std::int32_t tag = 0)
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Recv(data, size, data_type.native(), source, tag, native_, MPI_STATUS_IGNORE);
+#endif
+  }
+  template <typename type>
+  request                irecv  (type* data, std::int32_t size, const data_type& data_type, const std::int32_t source, const std::int32_t tag = 0)
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Request result;
+    MPI_Irecv(data, size, data_type.native(), source, tag, native_, &result);
+    return request(result);
+#else
+    return request();
+#endif
+  }
+  // Blocks until a message with the given tag is available, and returns its source.
+  std::int32_t           probe  (const std::int32_t source = any_source, const std::int32_t tag = 0)
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Status status;
+    MPI_Probe(source, tag, native_, &status);
+    return status.MPI_SOURCE;
+#else
+    return source;
+#endif
+  }
+  // Returns the source of a message with the given tag if one is available, without blocking.
+  std::optional<std::int32_t> iprobe(const std::int32_t source = any_source, const std::int32_t tag = 0)
+  {
+#ifdef ASTRAY_USE_MPI
+    auto       available = 0;
+    MPI_Status status;
+    MPI_Iprobe(source, tag, native_, &available, &status);
+    if (available)
+      return status.MPI_SOURCE;
+#endif
+    return std::nullopt;
+  }
+
   std::int32_t           rank   () const
   {
     std::int32_t result(0);
@@ -69,6 +233,18 @@ public:
   }
 
 protected:
-  std::int32_t native_;
+  void                   free   ()
+  {
+#ifdef ASTRAY_USE_MPI
+    auto finalized = 0;
+    MPI_Finalized(&finalized);
+    if (managed_ && !finalized)
+      MPI_Comm_free(&native_);
+#endif
+    managed_ = false;
+  }
+
+  std::int32_t native_ ;
+  bool         managed_;
 };
 }
\ No newline at end of file
@@ -16,7 +16,9 @@ public:
     MPI_Initialized(&initialized);
     if (!initialized)
     {
-      MPI_Init(nullptr, nullptr);
+      // Asynchronous rendering gathers on a separate thread, one thread at a time.
+      auto provided = 0;
+      MPI_Init_thread(nullptr, nullptr, MPI_THREAD_SERIALIZED, &provided);
       finalize_ = true;
     }
 #endif
@@ -35,6 +37,19 @@ public:
   environment& operator=(const environment&  that) = delete;
   environment& operator=(      environment&& temp) = delete;
 
+  // Whether MPI may be called from a thread other than the main thread, one thread at a time. MPI may have been
+  // initialized elsewhere with a lower level than requested.
+  static bool serialized()
+  {
+#ifdef ASTRAY_USE_MPI
+    auto provided = 0;
+    MPI_Query_thread(&provided);
+    return provided >= MPI_THREAD_SERIALIZED;
+#else
+    return true;
+#endif
+  }
+
 protected:
   bool finalize_ = false;
 };
@@ -2,4 +2,6 @@
 
 #include <astray/parallel/mpi/communicator.hpp>
 #include <astray/parallel/mpi/data_type.hpp>
-#include <astray/parallel/mpi/environment.hpp>
\ No newline at end of file
+#include <astray/parallel/mpi/environment.hpp>
+#include <astray/parallel/mpi/request.hpp>
+#include <astray/parallel/mpi/shared_window.hpp>
\ No newline at end of file
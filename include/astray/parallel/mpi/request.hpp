@@ -0,0 +1,88 @@
+#pragma once
+
+#include <utility>
+
+#ifdef ASTRAY_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace ast::mpi
+{
+// The handle of a non-blocking operation. Waits for the operation on destruction, hence the buffers of the operation
+// have to outlive the request.
+class request
+{
+public:
+  request           ()                     = default;
+#ifdef ASTRAY_USE_MPI
+  explicit request  (const MPI_Request native)
+  : native_(native)
+  {
+
+  }
+#endif
+  request           (const request&  that) = delete;
+  request           (      request&& temp) noexcept
+  {
+    swap(temp);
+  }
+  virtual ~request  ()
+  {
+    wait();
+  }
+  request& operator=(const request&  that) = delete;
+  request& operator=(      request&& temp) noexcept
+  {
+    if (this != &temp)
+    {
+      wait();
+      swap(temp);
+    }
+    return *this;
+  }
+
+  // A no-op after finalization, when the request can no longer be completed.
+  void wait  ()
+  {
+#ifdef ASTRAY_USE_MPI
+    auto finalized = 0;
+    MPI_Finalized(&finalized);
+    if (native_ != MPI_REQUEST_NULL && !finalized)
+      MPI_Wait(&native_, MPI_STATUS_IGNORE);
+#endif
+  }
+  // Returns true if the operation is complete.
+  bool test  ()
+  {
+#ifdef ASTRAY_USE_MPI
+    if (native_ == MPI_REQUEST_NULL)
+      return true;
+    auto complete = 0;
+    MPI_Test(&native_, &complete, MPI_STATUS_IGNORE);
+    return complete != 0;
+#else
+    return true;
+#endif
+  }
+  bool active() const
+  {
+#ifdef ASTRAY_USE_MPI
+    return native_ != MPI_REQUEST_NULL;
+#else
+    return false;
+#endif
+  }
+
+protected:
+  void swap  (request& that) noexcept
+  {
+#ifdef ASTRAY_USE_MPI
+    std::swap(native_, that.native_);
+#endif
+  }
+
+#ifdef ASTRAY_USE_MPI
+  MPI_Request native_ = MPI_REQUEST_NULL;
+#endif
+};
+}
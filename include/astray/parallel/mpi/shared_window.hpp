@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#ifdef ASTRAY_USE_MPI
+#include <mpi.h>
+#endif
+
+#include <astray/parallel/mpi/communicator.hpp>
+#include <astray/parallel/mpi/data_type.hpp>
+
+namespace ast::mpi
+{
+// An array in memory shared by the ranks of a node communicator (see communicator::split_shared). It is allocated by
+// rank 0 of the node, and read and written in place by all ranks of the node. Without MPI, it is backed by a vector.
+template <typename type>
+class shared_window
+{
+public:
+  shared_window           () = default;
+  explicit shared_window  (const communicator& node, const std::size_t size)
+  : size_(size)
+  {
+#ifdef ASTRAY_USE_MPI
+    type* base = nullptr;
+    MPI_Win_allocate_shared(static_cast<MPI_Aint>(node.rank() == 0 ? size * sizeof(type) : 0), static_cast<std::int32_t>(sizeof(type)), MPI_INFO_NULL, node.native(), &base, &native_);
+
+    MPI_Aint     segment_size      = 0;
+    std::int32_t displacement_unit = 0;
+    MPI_Win_shared_query(native_, 0, &segment_size, &displacement_unit, &data_);
+#else
+    storage_.resize(size);
+    data_ = storage_.data();
+#endif
+  }
+  shared_window           (const shared_window&  that) = delete;
+  shared_window           (      shared_window&& temp) noexcept
+  {
+    swap(temp);
+  }
+  virtual ~shared_window  ()
+  {
+    free();
+  }
+  shared_window& operator=(const shared_window&  that) = delete;
+  shared_window& operator=(      shared_window&& temp) noexcept
+  {
+    if (this != &temp)
+    {
+      free();
+      swap(temp);
+    }
+    return *this;
+  }
+
+  type*       data ()
+  {
+    return data_;
+  }
+  const type* data () const
+  {
+    return data_;
+  }
+  std::size_t size () const
+  {
+    return size_;
+  }
+
+  // Collective over the node. Completes the writes of all ranks of the node before any rank reads the window.
+  void        fence()
+  {
+#ifdef ASTRAY_USE_MPI
+    MPI_Win_fence(0, native_);
+#endif
+  }
+
+protected:
+  void        free ()
+  {
+#ifdef ASTRAY_USE_MPI
+    auto finalized = 0;
+    MPI_Finalized(&finalized);
+    if (native_ != MPI_WIN_NULL && !finalized)
+      MPI_Win_free(&native_);
+    native_ = MPI_WIN_NULL;
+#else
+    storage_.clear();
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+  void        swap (shared_window& that) noexcept
+  {
+#ifdef ASTRAY_USE_MPI
+    std::swap(native_ , that.native_ );
+#else
+    std::swap(storage_, that.storage_);
+#endif
+    std::swap(data_   , that.data_   );
+    std::swap(size_   , that.size_   );
+  }
+
+#ifdef ASTRAY_USE_MPI
+  MPI_Win           native_  = MPI_WIN_NULL;
+#else
+  std::vector<type> storage_ ;
+#endif
+  type*             data_    = nullptr;
+  std::size_t       size_    = 0;
+};
+
+// Distributes the array of rank 0 of the communicator into a shared window on each node: it is broadcast among one
+// leader rank per node, each of which writes it into the window of its node. Hence each node holds a single copy of the
+// array (e.g. of the background or of any other lookup table) regardless of the number of ranks. The data is only read
+// on rank 0, the other ranks may pass nullptr.
+template <typename type>
+shared_window<type> share(communicator& communicator, const type* data, std::size_t size)
+{
+#ifdef ASTRAY_USE_MPI
+  auto count = static_cast<std::uint64_t>(size);
+  communicator.bcast(&count, 1, data_type(MPI_UINT64_T));
+
+  auto node    = communicator.split_shared();
+  auto leaders = communicator.split(node.rank() == 0 ? 0 : undefined, communicator.rank());
+
+  shared_window<type> result(node, static_cast<std::size_t>(count));
+  if (node.rank() == 0 && count > 0)
+  {
+    if (communicator.rank() == 0)
+      std::copy_n(data, count, result.data());
+
+    // Broadcast in chunks, as the counts of MPI are limited to 32 bits.
+    constexpr std::uint64_t chunk_size = std::uint64_t(1) << 30;
+    const data_type         byte_data_type(MPI_BYTE);
+    auto*                   bytes      = reinterpret_cast<std::uint8_t*>(result.data());
+    const auto              byte_count = count * sizeof(type);
+    for (std::uint64_t offset = 0; offset < byte_count; offset += chunk_size)
+      leaders.bcast(bytes + offset, static_cast<std::int32_t>(std::min(chunk_size, byte_count - offset)), byte_data_type);
+  }
+  result.fence();
+  return result;
+#else
+  shared_window<type> result(communicator, size);
+  std::copy_n(data, size, result.data());
+  return result;
+#endif
+}
+}
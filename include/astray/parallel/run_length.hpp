@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace ast
+{
+// A fast, dependency-free codec for the payloads of gathers. The elements (e.g. pixels or endpoints) are optionally
+// delta coded byte-wise against their predecessor, which turns smooth gradients into runs of equal elements, and then
+// run length coded: a token below 128 is followed by token + 1 literal elements, a token of 128 or above by a single
+// element which is repeated token - 126 times.
+namespace run_length
+{
+constexpr std::size_t max_literals = 128;
+constexpr std::size_t max_repeats  = 129;
+
+inline std::vector<std::uint8_t> encode(const std::uint8_t* data, const std::size_t count, const std::size_t element_size, const bool delta = true)
+{
+  std::vector<std::uint8_t> deltas;
+  if (delta && count > 0)
+  {
+    deltas.resize(count * element_size);
+    std::copy_n(data, element_size, deltas.begin());
+    for (std::size_t i = element_size; i < deltas.size(); ++i)
+      deltas[i] = static_cast<std::uint8_t>(data[i] - data[i - element_size]);
+    data = deltas.data();
+  }
+
+  const auto element = [&] (const std::size_t index) { return data + index * element_size; };
+  const auto equal   = [&] (const std::size_t lhs, const std::size_t rhs) { return std::memcmp(element(lhs), element(rhs), element_size) == 0; };
+
+  std::vector<std::uint8_t> result;
+  result.reserve(count * element_size / 4 + 16);
+
+  std::size_t i = 0;
+  while (i < count)
+  {
+    std::size_t repeats = 1;
+    while (i + repeats < count && repeats < max_repeats && equal(i, i + repeats))
+      ++repeats;
+    if (repeats > 1)
+    {
+      result.push_back(static_cast<std::uint8_t>(repeats + 126));
+      result.insert   (result.end(), element(i), element(i + 1));
+      i += repeats;
+      continue;
+    }
+
+    // Literals extend up to the start of the next run.
+    std::size_t literals = 1;
+    while (i + literals < count && literals < max_literals && !(i + literals + 1 < count && equal(i + literals, i + literals + 1)))
+      ++literals;
+    result.push_back(static_cast<std::uint8_t>(literals - 1));
+    result.insert   (result.end(), element(i), element(i + literals));
+    i += literals;
+  }
+  return result;
+}
+
+// Decodes count elements of element_size bytes into the result, which has to be large enough to hold them.
+inline void                      decode(const std::uint8_t* data, const std::size_t size, const std::size_t count, const std::size_t element_size, std::uint8_t* result, const bool delta = true)
+{
+  const auto end = data + size;
+
+  std::size_t i = 0;
+  while (i < count)
+  {
+    if (data == end)
+      throw std::runtime_error("Truncated run length stream.");
+
+    const auto token    = *data++;
+    const auto repeats  = token >= max_literals ? static_cast<std::size_t>(token) - 126 : 1;
+    const auto literals = token >= max_literals ? 1 : static_cast<std::size_t>(token) + 1;
+    if (i + repeats * literals > count || static_cast<std::size_t>(end - data) < literals * element_size)
+      throw std::runtime_error("Invalid run length stream.");
+
+    auto* target = result + i * element_size;
+    std::copy_n(data, literals * element_size, target);
+    for (std::size_t j = 1; j < repeats; ++j)
+      std::copy_n(data, element_size, target + j * element_size);
+    data += literals * element_size;
+    i    += repeats * literals;
+  }
+
+  if (delta)
+    for (std::size_t j = element_size; j < count * element_size; ++j)
+      result[j] = static_cast<std::uint8_t>(result[j] + result[j - element_size]);
+}
+}
+}
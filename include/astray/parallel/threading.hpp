@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace ast
+{
+// The placement of the threads of the ranks on a node:
+// - none   : Threads are not pinned.
+// - compact: The threads of each rank are pinned to adjacent processors, the ranks occupy consecutive ranges.
+// - spread : The threads of each rank are pinned to processors spread across the node, interleaved with the other ranks.
+// - socket : The ranks are distributed round robin across the sockets, and their threads are pinned to adjacent
+//            processors of their socket, hence each rank streams from the memory of its own NUMA domain.
+enum class thread_affinity
+{
+  none   ,
+  compact,
+  spread ,
+  socket
+};
+
+namespace threading
+{
+// The processors the process may run on, through the affinity mask it was started with (e.g. restricted by a cpuset, by
+// OMP_PROC_BIND or by the launcher). Queried once, before any thread is pinned by configure.
+inline const std::vector<std::int32_t>& available_processors()
+{
+  static const auto result = [ ]
+  {
+    std::vector<std::int32_t> processors;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+      for (auto processor = 0; processor < CPU_SETSIZE; ++processor)
+        if (CPU_ISSET(processor, &set))
+          processors.push_back(processor);
+#endif
+    if (processors.empty())
+    {
+#ifdef _OPENMP
+      const auto count = std::max(omp_get_num_procs(), 1);
+#else
+      const auto count = static_cast<std::int32_t>(std::max(std::thread::hardware_concurrency(), 1u));
+#endif
+      for (auto processor = 0; processor < count; ++processor)
+        processors.push_back(processor);
+    }
+    return processors;
+  }();
+  return result;
+}
+// Whether the process is restricted to a subset of the processors of the node, i.e. the launcher has already divided the
+// node among the ranks.
+inline bool restricted()
+{
+  return available_processors().size() < std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// The available processors of each socket of the node, through the topology of sysfs. A single socket if it is not
+// available.
+inline std::vector<std::vector<std::int32_t>> sockets()
+{
+  std::map<std::int32_t, std::vector<std::int32_t>> result;
+  for (const auto processor : available_processors())
+  {
+    std::ifstream stream("/sys/devices/system/cpu/cpu" + std::to_string(processor) + "/topology/physical_package_id");
+    auto          socket = 0;
+    if (!(stream >> socket))
+      socket = 0;
+    result[socket].push_back(processor);
+  }
+
+  std::vector<std::vector<std::int32_t>> sockets;
+  for (auto& [socket, processors] : result)
+    sockets.push_back(std::move(processors));
+  return sockets;
+}
+
+// The processor of each thread of the given rank among the node_rank_count ranks of a node. The number of threads is
+// the share of the rank of the available processors of the node (of its socket for the socket affinity) unless it is
+// given. If the launcher has restricted the process to a subset of the node, the subset is not divided any further.
+inline std::vector<std::int32_t> processors(const thread_affinity affinity, std::int32_t node_rank, std::int32_t node_rank_count, std::int32_t thread_count = 0)
+{
+  if (restricted())
+  {
+    node_rank       = 0;
+    node_rank_count = 1;
+  }
+
+  auto candidates = available_processors();
+  auto rank       = node_rank;
+  auto rank_count = node_rank_count;
+  if (affinity == thread_affinity::socket)
+  {
+    const auto socket_list  = sockets();
+    const auto socket_count = static_cast<std::int32_t>(socket_list.size());
+    candidates = socket_list[node_rank % socket_count];
+    rank       = node_rank / socket_count;
+    rank_count = node_rank_count / socket_count + (node_rank % socket_count < node_rank_count % socket_count ? 1 : 0);
+  }
+
+  const auto candidate_count = static_cast<std::int32_t>(candidates.size());
+  const auto share           = std::max(candidate_count / rank_count, 1);
+  if (thread_count <= 0)
+    thread_count = share;
+
+  std::vector<std::int32_t> result(thread_count);
+  for (auto thread = 0; thread < thread_count; ++thread)
+    result[thread] = affinity == thread_affinity::spread
+      ? candidates[(thread * rank_count + rank) % candidate_count]
+      : candidates[(rank * share + thread) % candidate_count];
+  return result;
+}
+
+// Sets the number of threads of OpenMP and pins them according to the affinity. The affinity none leaves the pinning to
+// the environment (it only restores the original masks if threads were pinned before). The calling thread is restricted
+// to all processors of the rank rather than to the one of its thread, as the threads it spawns later (e.g. of the
+// asynchronous gathers or of the video encoders) inherit its mask. Has no effect without OpenMP.
+inline std::int32_t configure(const thread_affinity affinity, const std::int32_t node_rank, const std::int32_t node_rank_count, const std::int32_t thread_count = 0)
+{
+  const auto thread_processors = processors(affinity, node_rank, node_rank_count, thread_count);
+  const auto count             = static_cast<std::int32_t>(thread_processors.size());
+#ifdef _OPENMP
+  omp_set_num_threads(count);
+#ifdef __linux__
+  static auto pinned = false;
+  if (affinity == thread_affinity::none && !pinned)
+    return count;
+
+  const auto make_set = [ ] (const std::vector<std::int32_t>& processors)
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto processor : processors)
+      CPU_SET(processor, &set);
+    return set;
+  };
+  const auto original = make_set(available_processors());
+  const auto rank     = make_set(thread_processors);
+
+  #pragma omp parallel
+  {
+    const auto thread = omp_get_thread_num();
+    const auto set    = affinity == thread_affinity::none ? original : thread == 0 ? rank : make_set({thread_processors[thread % count]});
+    sched_setaffinity(0, sizeof(set), &set);
+  }
+  pinned = affinity != thread_affinity::none;
+#endif
+#endif
+  return count;
+}
+
+// Fills the elements with the value by the threads of OpenMP, in the static schedule of the parallel loops of the
+// device system. The pages of the memory which were touched before (e.g. through the value initialization of a vector)
+// are released first, hence the pages are placed in the NUMA domains of the threads which will process them.
+template <typename type>
+void first_touch(type* data, const std::size_t size, const type& value)
+{
+#if defined(_OPENMP) && defined(__linux__)
+  const auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+  const auto begin     = (reinterpret_cast<std::uintptr_t>(data       ) + page_size - 1) / page_size * page_size;
+  const auto end       =  reinterpret_cast<std::uintptr_t>(data + size)                  / page_size * page_size;
+  if (end > begin)
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+
+  #pragma omp parallel for schedule(static)
+  for (std::int64_t i = 0; i < static_cast<std::int64_t>(size); ++i)
+    data[i] = value;
+#else
+  std::fill_n(data, size, value);
+#endif
+}
+}
+}
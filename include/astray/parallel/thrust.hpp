@@ -7,6 +7,7 @@ DISABLE_WARNING_PRAGMAS
 DISABLE_WARNING_NO_DEPRECATED_GPU_TARGETS
 #include <thrust/iterator/counting_iterator.h>
 #include <thrust/device_vector.h>
+#include <thrust/execution_policy.h>
 #include <thrust/for_each.h>
 
 #ifdef __CUDACC__
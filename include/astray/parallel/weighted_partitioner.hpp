@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <astray/math/indexing.hpp>
+#include <astray/parallel/partitioner.hpp>
+
+namespace ast
+{
+// Partitions an N-dimensional domain like the partitioner while no weights are set. Otherwise, the domain is split by
+// recursive coordinate bisection of the given cost estimate, so that each rank receives blocks of roughly equal cost
+// rather than of equal size. The weights are defined on a (lower resolution) grid of weights_size which is stretched
+// over the domain. The blocks of weighted partitions differ in size, hence the grid_size and rank_multi_index are not
+// meaningful for them: use block_offsets and block_sizes instead. If the node of each rank is set, the domain is instead
+// split into bands along its outermost dimension, ordered by node, hence the blocks of the ranks of each node form a
+// single contiguous stripe of the domain (see ray_tracer::set_node_aware). The bands are of equal cost if weights are
+// set, and of equal size otherwise.
+template <std::size_t dimensions, typename size_type = std::size_t, typename multi_size_type = std::array<size_type, dimensions>, bool fortran_order = false>
+class weighted_partitioner : public partitioner<dimensions, size_type, multi_size_type, fortran_order>
+{
+public:
+  using base_type = partitioner<dimensions, size_type, multi_size_type, fortran_order>;
+
+  explicit weighted_partitioner(
+    const size_type           communicator_rank,
+    const size_type           communicator_size,
+    const multi_size_type&    domain_size      ,
+    const std::vector<float>& weights          = {},
+    const multi_size_type&    weights_size     = {})
+  : base_type    (communicator_rank, communicator_size, domain_size)
+  , weights_     (weights     )
+  , weights_size_(weights_size)
+  {
+    weighted_partitioner<dimensions, size_type, multi_size_type, fortran_order>::update();
+  }
+  weighted_partitioner           (const weighted_partitioner&  that) = default;
+  weighted_partitioner           (      weighted_partitioner&& temp) = default;
+  virtual ~weighted_partitioner  ()                                  = default;
+  weighted_partitioner& operator=(const weighted_partitioner&  that) = default;
+  weighted_partitioner& operator=(      weighted_partitioner&& temp) = default;
+
+  // Empty weights restore the equal partitioning.
+  void                                set_weights  (const std::vector<float>& weights, const multi_size_type& weights_size)
+  {
+    if (!weights.empty() && weights.size() != static_cast<std::size_t>(product(weights_size)))
+      throw std::runtime_error("The weights do not match the weights size.");
+
+    weights_      = weights;
+    weights_size_ = weights_size;
+    update();
+  }
+  const std::vector<float>&           weights      () const
+  {
+    return weights_;
+  }
+  const multi_size_type&              weights_size () const
+  {
+    return weights_size_;
+  }
+  bool                                weighted     () const
+  {
+    return !weights_.empty();
+  }
+
+  // Empty nodes restore the partitioning by weights or the equal partitioning.
+  void                                set_nodes    (const std::vector<size_type>& nodes)
+  {
+    if (!nodes.empty() && nodes.size() != static_cast<std::size_t>(this->communicator_size_))
+      throw std::runtime_error("The nodes do not match the communicator size.");
+
+    nodes_ = nodes;
+    update();
+  }
+  const std::vector<size_type>&       nodes        () const
+  {
+    return nodes_;
+  }
+  bool                                node_aware   () const
+  {
+    return !nodes_.empty();
+  }
+  // Whether the blocks are equal and arranged on the grid of the partitioner.
+  bool                                uniform      () const
+  {
+    return !weighted() && !node_aware();
+  }
+
+  // The blocks of all ranks.
+  const std::vector<multi_size_type>& block_offsets() const
+  {
+    return block_offsets_;
+  }
+  const std::vector<multi_size_type>& block_sizes  () const
+  {
+    return block_sizes_;
+  }
+
+protected:
+  void                                update       () override
+  {
+    base_type::update();
+
+    block_offsets_.resize(this->communicator_size_);
+    block_sizes_  .resize(this->communicator_size_);
+    if (uniform())
+    {
+      for (size_type rank = 0; rank < this->communicator_size_; ++rank)
+      {
+        const auto multi_index = unravel_index<multi_size_type, fortran_order>(rank, this->grid_size_);
+        block_sizes_  [rank] = this->block_size_;
+        std::transform(this->block_size_.begin(), this->block_size_.end(), multi_index.begin(), block_offsets_[rank].begin(), std::multiplies<>());
+      }
+      return;
+    }
+
+    multi_size_type offset {};
+    std::fill(offset.begin(), offset.end(), 0);
+    if (node_aware())
+      split_bands(offset, this->domain_size_);
+    else
+      bisect     (offset, this->domain_size_, 0, this->communicator_size_);
+
+    this->grid_size_       .fill(1);
+    this->rank_multi_index_.fill(0);
+    this->block_size_  = block_sizes_  [this->communicator_rank_];
+    this->rank_offset_ = block_offsets_[this->communicator_rank_];
+  }
+
+  // Splits the block among the ranks [first_rank, last_rank), cutting its longest dimension where the cumulative cost
+  // reaches the share of the first half of the ranks.
+  void                                bisect       (const multi_size_type& offset, const multi_size_type& size, const size_type first_rank, const size_type last_rank)
+  {
+    const auto rank_count = last_rank - first_rank;
+    if (rank_count == 1)
+    {
+      block_offsets_[first_rank] = offset;
+      block_sizes_  [first_rank] = size;
+      return;
+    }
+
+    const auto dimension  = static_cast<std::size_t>(std::distance(size.begin(), std::max_element(size.begin(), size.end())));
+    const auto lower_rank = rank_count / 2;
+
+    const auto cumulative_costs = slice_costs(offset, size, dimension);
+    auto       cut              = find_cut(cumulative_costs, cumulative_costs.back() * static_cast<double>(lower_rank) / static_cast<double>(rank_count));
+    if (size[dimension] > 1) // Both halves receive at least one slice if possible.
+      cut = std::clamp<size_type>(cut, 1, size[dimension] - 1);
+
+    auto lower_size   = size  ; lower_size  [dimension]  = cut;
+    auto upper_size   = size  ; upper_size  [dimension] -= cut;
+    auto upper_offset = offset; upper_offset[dimension] += cut;
+    bisect(offset      , lower_size, first_rank             , first_rank + lower_rank);
+    bisect(upper_offset, upper_size, first_rank + lower_rank, last_rank              );
+  }
+
+  // Splits the block into one band per rank along the outermost dimension, assigned to the ranks ordered by node.
+  void                                split_bands  (const multi_size_type& offset, const multi_size_type& size)
+  {
+    const auto dimension  = fortran_order ? dimensions - 1 : 0;
+    const auto rank_count = this->communicator_size_;
+
+    std::vector<size_type> ranks(rank_count);
+    std::iota       (ranks.begin(), ranks.end(), 0);
+    std::stable_sort(ranks.begin(), ranks.end(), [&] (const size_type lhs, const size_type rhs) { return nodes_[lhs] < nodes_[rhs]; });
+
+    const auto cumulative_costs = slice_costs(offset, size, dimension);
+    size_type  begin            = 0;
+    for (size_type i = 0; i < rank_count; ++i)
+    {
+      auto end = i + 1 == rank_count ? size[dimension] : find_cut(cumulative_costs, cumulative_costs.back() * static_cast<double>(i + 1) / static_cast<double>(rank_count));
+      if (size[dimension] >= rank_count) // Each band receives at least one slice if possible.
+        end = std::clamp<size_type>(end, begin + 1, size[dimension] - (rank_count - i - 1));
+      end = std::max(end, begin);
+
+      auto band_offset = offset; band_offset[dimension] += begin;
+      auto band_size   = size  ; band_size  [dimension]  = end - begin;
+      block_offsets_[ranks[i]] = band_offset;
+      block_sizes_  [ranks[i]] = band_size  ;
+      begin = end;
+    }
+  }
+
+  // The cumulative cost of the slices of the block along the dimension, through the costs of the cells of the weight
+  // grid. Without cost information, the slices are of unit cost.
+  std::vector<double>                 slice_costs  (const multi_size_type& offset, const multi_size_type& size, const std::size_t dimension) const
+  {
+    std::vector<double> cell_costs(weighted() ? weights_size_[dimension] : 0, 0.0);
+    for (std::size_t index = 0; index < weights_.size(); ++index)
+    {
+      const auto cell     = unravel_index<multi_size_type, fortran_order>(index, weights_size_);
+      auto       coverage = 1.0;
+      for (std::size_t i = 0; i < dimensions && coverage > 0.0; ++i)
+        if (i != dimension)
+          coverage *= static_cast<double>(cell_overlap(i, cell[i], offset[i], offset[i] + size[i]));
+      cell_costs[cell[dimension]] += coverage * static_cast<double>(weights_[index]);
+    }
+
+    std::vector<double> cumulative_costs(size[dimension] + 1, 0.0);
+    if (weighted())
+      for (size_type i = 0; i < size[dimension]; ++i)
+        cumulative_costs[i + 1] = cumulative_costs[i] + cell_costs[cell_index(dimension, offset[dimension] + i)];
+    if (!(cumulative_costs.back() > 0.0))
+      for (size_type i = 0; i <= size[dimension]; ++i)
+        cumulative_costs[i] = static_cast<double>(i);
+    return cumulative_costs;
+  }
+  // The slice boundary closest to the target cost.
+  static size_type                    find_cut     (const std::vector<double>& cumulative_costs, const double target)
+  {
+    auto cut = static_cast<size_type>(std::distance(cumulative_costs.begin(), std::lower_bound(cumulative_costs.begin(), cumulative_costs.end(), target)));
+    if (cut > 0 && target - cumulative_costs[cut - 1] < cumulative_costs[cut] - target)
+      --cut;
+    return cut;
+  }
+
+  // The weight cell of the given element along the dimension, and the number of elements in [begin, end) in the cell.
+  size_type                           cell_index   (const std::size_t dimension, const size_type element) const
+  {
+    return static_cast<size_type>(static_cast<std::size_t>(element) * weights_size_[dimension] / this->domain_size_[dimension]);
+  }
+  size_type                           cell_overlap (const std::size_t dimension, const size_type cell, const size_type begin, const size_type end) const
+  {
+    const auto cell_begin = static_cast<size_type>((static_cast<std::size_t>(cell    ) * this->domain_size_[dimension] + weights_size_[dimension] - 1) / weights_size_[dimension]);
+    const auto cell_end   = static_cast<size_type>((static_cast<std::size_t>(cell + 1) * this->domain_size_[dimension] + weights_size_[dimension] - 1) / weights_size_[dimension]);
+    return std::min(end, cell_end) > std::max(begin, cell_begin) ? std::min(end, cell_end) - std::max(begin, cell_begin) : 0;
+  }
+  static size_type                    product      (const multi_size_type& value)
+  {
+    size_type result = 1;
+    for (const auto element : value)
+      result *= element;
+    return result;
+  }
+
+  std::vector<float>           weights_      ;
+  multi_size_type              weights_size_ ;
+  std::vector<multi_size_type> block_offsets_;
+  std::vector<multi_size_type> block_sizes_  ;
+  std::vector<size_type>       nodes_        ;
+};
+}
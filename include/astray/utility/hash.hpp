@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+namespace ast
+{
+// Accumulates a 64-bit FNV-1a hash, e.g. of all parameters which affect a rendering (see ray_tracer::scene_hash). The
+// hash identifies parameters across runs, but is not suitable against intentional collisions.
+class hasher
+{
+public:
+  hasher& add(const void* data, const std::size_t size)
+  {
+    const auto bytes = static_cast<const std::uint8_t*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+      value_ = (value_ ^ bytes[i]) * prime;
+    return *this;
+  }
+  hasher& add(const std::string_view value)
+  {
+    add(static_cast<std::uint64_t>(value.size()));
+    return add(value.data(), value.size());
+  }
+  hasher& add(const char*            value)
+  {
+    return add(std::string_view(value));
+  }
+  // Hashes the object representation of the value. The value is copied into zeroed memory first, so that padding does
+  // not alter the hash in practice, and the virtual table pointer of polymorphic types (e.g. metrics) is skipped.
+  template <typename type>
+  hasher& add(const type& value)
+  {
+    static_assert(std::is_copy_constructible_v<type> && !std::is_pointer_v<type>, "The hashed type has to be a copy constructible value.");
+
+    alignas(type) std::uint8_t storage[sizeof(type)];
+    std::memset(storage, 0, sizeof(type));
+    const auto copy = new (storage) type(value);
+
+    constexpr std::size_t begin = std::is_polymorphic_v<type> ? sizeof(void*) : 0;
+    add(storage + begin, sizeof(type) - begin);
+    copy->~type();
+    return *this;
+  }
+  template <typename... types>
+  hasher& add(const std::variant<types...>& value)
+  {
+    add(static_cast<std::uint64_t>(value.index()));
+    std::visit([&] (const auto& alternative) { add(alternative); }, value);
+    return *this;
+  }
+
+  std::uint64_t value() const
+  {
+    return value_;
+  }
+
+protected:
+  static constexpr std::uint64_t offset_basis = 14695981039346656037ull;
+  static constexpr std::uint64_t prime        = 1099511628211ull;
+
+  std::uint64_t value_ = offset_basis;
+};
+}
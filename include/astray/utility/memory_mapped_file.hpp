@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ast
+{
+class memory_mapped_file
+{
+public:
+  // Maps an existing file for reading.
+  explicit memory_mapped_file  (const std::filesystem::path& filepath)
+  {
+    open(filepath, 0, false);
+  }
+  // Creates (or truncates) a file of the given size and maps it for writing.
+  explicit memory_mapped_file  (const std::filesystem::path& filepath, const std::size_t size)
+  {
+    open(filepath, size, true);
+  }
+  memory_mapped_file           (const memory_mapped_file&  that) = delete;
+  memory_mapped_file           (      memory_mapped_file&& temp) noexcept
+  {
+    swap(temp);
+  }
+  virtual ~memory_mapped_file  ()
+  {
+    close();
+  }
+  memory_mapped_file& operator=(const memory_mapped_file&  that) = delete;
+  memory_mapped_file& operator=(      memory_mapped_file&& temp) noexcept
+  {
+    if (this != &temp)
+    {
+      close();
+      swap (temp);
+    }
+    return *this;
+  }
+
+  std::uint8_t*       data    ()
+  {
+    return data_;
+  }
+  const std::uint8_t* data    () const
+  {
+    return data_;
+  }
+  std::size_t         size    () const
+  {
+    return size_;
+  }
+  bool                writable() const
+  {
+    return writable_;
+  }
+
+protected:
+  void open (const std::filesystem::path& filepath, const std::size_t size, const bool writable)
+  {
+    writable_ = writable;
+
+    // Closes the file before throwing, as the destructor does not run if the constructor throws.
+    const auto fail = [&] (const char* message)
+    {
+      close();
+      throw std::runtime_error(message);
+    };
+
+#ifdef _WIN32
+    file_ = CreateFileW(filepath.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr, writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+      throw std::runtime_error("Failed CreateFileW.");
+
+    if (writable)
+      size_ = size;
+    else
+    {
+      LARGE_INTEGER file_size;
+      if (!GetFileSizeEx(file_, &file_size))
+        fail("Failed GetFileSizeEx.");
+      size_ = static_cast<std::size_t>(file_size.QuadPart);
+    }
+    if (size_ == 0)
+      return;
+
+    mapping_ = CreateFileMappingW(file_, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, static_cast<DWORD>(static_cast<std::uint64_t>(size_) >> 32), static_cast<DWORD>(size_ & 0xFFFFFFFF), nullptr);
+    if (!mapping_)
+      fail("Failed CreateFileMappingW.");
+
+    data_ = static_cast<std::uint8_t*>(MapViewOfFile(mapping_, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size_));
+    if (!data_)
+      fail("Failed MapViewOfFile.");
+#else
+    file_ = ::open(filepath.string().c_str(), writable ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+    if (file_ < 0)
+      throw std::runtime_error("Failed open.");
+
+    if (writable)
+    {
+      size_ = size;
+      if (ftruncate(file_, static_cast<off_t>(size_)) != 0)
+        fail("Failed ftruncate.");
+    }
+    else
+    {
+      struct stat file_status {};
+      if (fstat(file_, &file_status) != 0)
+        fail("Failed fstat.");
+      size_ = static_cast<std::size_t>(file_status.st_size);
+    }
+    if (size_ == 0)
+      return;
+
+    auto* data = mmap(nullptr, size_, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file_, 0);
+    if (data == MAP_FAILED)
+      fail("Failed mmap.");
+    data_ = static_cast<std::uint8_t*>(data);
+#endif
+  }
+  void close()
+  {
+#ifdef _WIN32
+    if (data_)
+      UnmapViewOfFile(data_);
+    if (mapping_)
+      CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE)
+      CloseHandle(file_);
+    mapping_ = nullptr;
+    file_    = INVALID_HANDLE_VALUE;
+#else
+    if (data_)
+      munmap(data_, size_);
+    if (file_ >= 0)
+      ::close(file_);
+    file_    = -1;
+#endif
+    data_    = nullptr;
+    size_    = 0;
+  }
+  void swap (memory_mapped_file& that)
+  {
+#ifdef _WIN32
+    std::swap(mapping_, that.mapping_);
+#endif
+    std::swap(file_    , that.file_    );
+    std::swap(data_    , that.data_    );
+    std::swap(size_    , that.size_    );
+    std::swap(writable_, that.writable_);
+  }
+
+#ifdef _WIN32
+  HANDLE        file_     = INVALID_HANDLE_VALUE;
+  HANDLE        mapping_  = nullptr;
+#else
+  std::int32_t  file_     = -1;
+#endif
+  std::uint8_t* data_     = nullptr;
+  std::size_t   size_     = 0;
+  bool          writable_ = false;
+};
+}
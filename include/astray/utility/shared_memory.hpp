@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ast
+{
+// A named POSIX shared memory object mapped for reading and writing. The creator unlinks the object on destruction,
+// the processes which have opened it retain their mappings until they close them.
+class shared_memory
+{
+public:
+  // Opens an existing object.
+  explicit shared_memory  (const std::string& name)
+  {
+    open(name, 0, false);
+  }
+  // Creates (or replaces) an object of the given size.
+  explicit shared_memory  (const std::string& name, const std::size_t size)
+  {
+    open(name, size, true);
+  }
+  shared_memory           (const shared_memory&  that) = delete;
+  shared_memory           (      shared_memory&& temp) noexcept
+  {
+    swap(temp);
+  }
+  virtual ~shared_memory  ()
+  {
+    close();
+  }
+  shared_memory& operator=(const shared_memory&  that) = delete;
+  shared_memory& operator=(      shared_memory&& temp) noexcept
+  {
+    if (this != &temp)
+    {
+      close();
+      swap (temp);
+    }
+    return *this;
+  }
+
+  std::uint8_t*       data ()
+  {
+    return data_;
+  }
+  const std::uint8_t* data () const
+  {
+    return data_;
+  }
+  std::size_t         size () const
+  {
+    return size_;
+  }
+  const std::string&  name () const
+  {
+    return name_;
+  }
+
+protected:
+  void open (const std::string& name, const std::size_t size, const bool create)
+  {
+#ifdef _WIN32
+    throw std::runtime_error("Shared memory is not supported on this platform.");
+#else
+    name_  = name;
+    owner_ = create;
+
+    if (create)
+      shm_unlink(name.c_str()); // Replace leftovers of crashed processes.
+
+    file_ = shm_open(name.c_str(), create ? O_RDWR | O_CREAT | O_EXCL : O_RDWR, 0644);
+    if (file_ < 0)
+      throw std::runtime_error("Failed shm_open.");
+
+    // Closes the descriptor and unlinks a created object before throwing.
+    const auto fail = [&] (const char* message)
+    {
+      close();
+      throw std::runtime_error(message);
+    };
+
+    if (create)
+    {
+      size_ = size;
+      if (ftruncate(file_, static_cast<off_t>(size_)) != 0)
+        fail("Failed ftruncate.");
+    }
+    else
+    {
+      struct stat file_status {};
+      if (fstat(file_, &file_status) != 0)
+        fail("Failed fstat.");
+      size_ = static_cast<std::size_t>(file_status.st_size);
+    }
+    if (size_ == 0)
+      return;
+
+    auto* data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, file_, 0);
+    if (data == MAP_FAILED)
+      fail("Failed mmap.");
+    data_ = static_cast<std::uint8_t*>(data);
+#endif
+  }
+  void close()
+  {
+#ifndef _WIN32
+    if (data_)
+      munmap(data_, size_);
+    if (file_ >= 0)
+      ::close(file_);
+    if (owner_)
+      shm_unlink(name_.c_str());
+#endif
+    file_  = -1;
+    data_  = nullptr;
+    size_  = 0;
+    owner_ = false;
+  }
+  void swap (shared_memory& that)
+  {
+    std::swap(name_ , that.name_ );
+    std::swap(file_ , that.file_ );
+    std::swap(data_ , that.data_ );
+    std::swap(size_ , that.size_ );
+    std::swap(owner_, that.owner_);
+  }
+
+  std::string   name_  ;
+  std::int32_t  file_  = -1;
+  std::uint8_t* data_  = nullptr;
+  std::size_t   size_  = 0;
+  bool          owner_ = false;
+};
+}
@@ -0,0 +1,60 @@
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::endpoint_buffer")
+{
+  using scalar_type     = float;
+  using metric_type     = ast::metrics::schwarzschild<scalar_type>;
+  using geodesic_type   = ast::geodesic<scalar_type, ast::runge_kutta_4_tableau<scalar_type>>;
+  using ray_tracer_type = ast::ray_tracer<metric_type, geodesic_type>;
+
+  ray_tracer_type ray_tracer({160, 120}, {}, 500, 0.05f, 0.0f, {}, {}, true);
+  ray_tracer.set_background(ray_tracer_type::image_type("../data/backgrounds/checkerboard.png"));
+  ray_tracer.get_observer().get_transform().translation = {0.0f, 0.0f, -10.0f};
+  ray_tracer.get_observer().get_transform().look_at({0.0f, 0.0f, 0.0f});
+
+  const auto image     = ray_tracer.render_frame();
+  const auto endpoints = ray_tracer.render_endpoints<ast::half>();
+  if (ray_tracer.get_communicator().rank() != 0)
+    return;
+
+  endpoints.save("../data/outputs/tests/endpoint_buffer_test.bin");
+  const ast::endpoint_buffer<ast::half> loaded("../data/outputs/tests/endpoint_buffer_test.bin");
+  REQUIRE(loaded.size == endpoints.size);
+  for (std::size_t i = 0; i < loaded.data.size(); ++i)
+  {
+    REQUIRE(loaded.data[i].theta.bits  == endpoints.data[i].theta.bits );
+    REQUIRE(loaded.data[i].phi  .bits  == endpoints.data[i].phi  .bits );
+    REQUIRE(loaded.data[i].termination == endpoints.data[i].termination);
+  }
+
+  // Dimensions which are not positive, overflow, or do not match the file are rejected, and leave the buffer unchanged.
+  for (const auto& corrupt_size : {ast::vector2<std::int32_t>(-160, -120), ast::vector2<std::int32_t>(0, 120), ast::vector2<std::int32_t>(65536, 65536), ast::vector2<std::int32_t>(120, 161)})
+  {
+    {
+      ast::memory_mapped_file file("../data/outputs/tests/endpoint_buffer_test_corrupt.bin", sizeof(ast::endpoint_buffer<ast::half>::header) + endpoints.data.size() * sizeof(ast::endpoint<ast::half>));
+      ast::endpoint_buffer<ast::half>::header header;
+      header.size[0] = corrupt_size[0];
+      header.size[1] = corrupt_size[1];
+      std::memcpy(file.data(), &header, sizeof(header));
+    }
+    ast::endpoint_buffer<ast::half> corrupt = loaded;
+    REQUIRE_THROWS(corrupt.load("../data/outputs/tests/endpoint_buffer_test_corrupt.bin"));
+    REQUIRE(corrupt.size        == loaded.size       );
+    REQUIRE(corrupt.data.size() == loaded.data.size());
+  }
+
+  // Half precision angles may fall to the neighboring texel, hence a small fraction of mismatching pixels is tolerated.
+  const auto shaded     = ray_tracer.shade(loaded);
+  auto       mismatches = 0;
+  for (std::size_t i = 0; i < shaded.data.size(); ++i)
+    if (shaded.data[i] != image.data[i])
+      ++mismatches;
+  REQUIRE(mismatches < static_cast<std::int32_t>(shaded.data.size() / 100));
+
+  ray_tracer.shade(loaded, ray_tracer_type::image_type("../data/backgrounds/checkerboard_gray.png")).save("../data/outputs/tests/endpoint_buffer_test.png");
+}
@@ -23,9 +23,46 @@ void test()
   thrust::copy(device_ray.begin(), device_ray.end(), ray.begin());
 }
 
+// Ray differentials are the Jacobi fields of the geodesic. In flat spacetime they grow linearly, in curved spacetime they
+// match the difference of neighboring geodesics.
+void test_differentials()
+{
+  using scalar_type        = double;
+  using vector_type        = ast::vector4<scalar_type>;
+  using ray_type           = ast::ray              <vector_type>;
+  using differentials_type = ast::ray_differentials<vector_type>;
+  using geodesic_type      = ast::geodesic<scalar_type, ast::runge_kutta_4_tableau<scalar_type>>;
+
+  {
+    ast::metrics::minkowski<scalar_type> metric;
+    ray_type           ray          {vector_type(0, 0, 0, 0), vector_type(-1, 0, 0, 1)};
+    differentials_type differentials;
+    differentials.position [0] = vector_type(0, 0.1, 0  , 0);
+    differentials.direction[1] = vector_type(0, 0  , 0.2, 0);
+    REQUIRE(geodesic_type::integrate(ray, differentials, metric, 100, 0.1) == ast::termination_reason::none);
+    REQUIRE((differentials.position[0] - vector_type(0, 0.1, 0          , 0)).norm() < 1e-6);
+    REQUIRE((differentials.position[1] - vector_type(0, 0  , 0.2 * 10.0 , 0)).norm() < 1e-6);
+  }
+  {
+    ast::metrics::schwarzschild<scalar_type> metric;
+    const vector_type  position (0, 20, ast::constants<scalar_type>::pi / 2, 0);
+    const vector_type  direction(-1, -1, 0, 0.01);
+    const vector_type  shift    (0, 0, 0, 1e-4);
+
+    ray_type           ray      {position, direction};
+    ray_type           neighbor {position, direction + shift};
+    differentials_type differentials;
+    differentials.direction[0] = shift / 1e-4;
+    geodesic_type::integrate(ray     , differentials, metric, 100, 0.1);
+    geodesic_type::integrate(neighbor,                metric, 100, 0.1);
+    REQUIRE(((neighbor.position - ray.position) / 1e-4 - differentials.position[0]).norm() < 1e-2 * differentials.position[0].norm());
+  }
+}
+
 TEST_CASE("ast::geodesic")
 {
   test();
+  test_differentials();
 
   // TODO
 }
\ No newline at end of file
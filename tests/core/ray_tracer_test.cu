@@ -27,6 +27,207 @@ TEST_CASE("ast::ray_tracer")
   ray_tracer.get_observer().set_projection(ast::perspective_projection<scalar_type> {ast::to_radians(75.0f), 640.0f / 480.0f});
 
   const auto image = ray_tracer.render_frame();
+
+  ray_tracer_type::image_type target;
+  ray_tracer.render_frame(target);
+  REQUIRE(target.data == image.data);
+  REQUIRE(ray_tracer.render_frame_async().get().data == image.data);
+
+  // The pixels traced along the curves are scattered back into the same frame.
+  for (const auto order : {ast::space_filling_curve_type::morton, ast::space_filling_curve_type::hilbert})
+  {
+    ray_tracer.get_observer().set_pixel_order(order);
+    REQUIRE(ray_tracer.render_frame().data == image.data);
+  }
+  ray_tracer.get_observer().set_pixel_order(ast::space_filling_curve_type::row_major);
+
+  auto transform        = ray_tracer.get_observer().get_transform();
+  transform.translation = {-0.1f, 0.1f, 10.0f};
+  transform.look_at({0.0f, 0.0f, 0.0f});
+  const auto views      = ray_tracer.render_frames({ray_tracer.get_observer().get_transform(), transform});
+  REQUIRE(views.size()  == 2);
+  REQUIRE(views[0].data == image.data);
+  REQUIRE(views[1].data == ray_tracer.render_frames({transform})[0].data);
+
+  // The cubemap differs from the equirectangular background only by resampling near the edges of the checkerboard.
+  ray_tracer.build_cubemap();
+  const auto cubemap_image = ray_tracer.render_frame();
+  auto       mismatches    = 0;
+  for (std::size_t i = 0; i < image.data.size(); ++i)
+    if (cubemap_image.data[i] != image.data[i])
+      ++mismatches;
+  REQUIRE(mismatches < static_cast<std::int32_t>(image.data.size()) / 20);
+
+  // Anti-aliasing only filters the background where the pixel footprints span several texels.
+  ray_tracer.set_cubemap     (std::nullopt);
+  ray_tracer.set_anti_aliased(true);
+  const auto anti_aliased_image = ray_tracer.render_frame();
+  mismatches = 0;
+  for (std::size_t i = 0; i < image.data.size(); ++i)
+    if (anti_aliased_image.data[i] != image.data[i])
+      ++mismatches;
+  REQUIRE(mismatches < static_cast<std::int32_t>(image.data.size()) / 2);
+  ray_tracer.set_anti_aliased(false);
+
+  // Tiled rendering assembles the same frame, including the partial tiles at the edges.
+  ray_tracer_type::image_type tiled_image(image.size, ray_tracer_type::pixel_type());
+  ray_tracer.render_tiles({100, 64}, [&] (const ray_tracer_type::image_type& tile, const ray_tracer_type::image_size_type& offset)
+  {
+    for (auto y = 0; y < tile.size[1]; ++y)
+      for (auto x = 0; x < tile.size[0]; ++x)
+        tiled_image.data[(offset[0] + x) + (offset[1] + y) * image.size[0]] = tile.data[x + y * tile.size[0]];
+  });
+  if (ray_tracer.get_communicator().rank() == 0)
+    REQUIRE(tiled_image.data == image.data);
+
+  // Dynamically distributed tiles assemble the same frame.
+  ray_tracer_type::image_type dynamic_image(image.size, ray_tracer_type::pixel_type());
+  ray_tracer.render_tiles_dynamic({100, 64}, [&] (const ray_tracer_type::image_type& tile, const ray_tracer_type::image_size_type& offset)
+  {
+    for (auto y = 0; y < tile.size[1]; ++y)
+      for (auto x = 0; x < tile.size[0]; ++x)
+        dynamic_image.data[(offset[0] + x) + (offset[1] + y) * image.size[0]] = tile.data[x + y * tile.size[0]];
+  });
+  if (ray_tracer.get_communicator().rank() == 0)
+    REQUIRE(dynamic_image.data == image.data);
+
+  // Checkpointed tiles are served from the checkpoint once they are finished, and the checkpoint is replaced once the
+  // scene changes.
+  const std::filesystem::path checkpoint_path("../data/outputs/tests/ray_tracer_test_checkpoint.bin");
+  std::filesystem::remove(checkpoint_path);
+  for (auto pass = 0; pass < 2; ++pass)
+  {
+    ray_tracer_type::image_type checkpointed_image(image.size, ray_tracer_type::pixel_type());
+    ray_tracer.render_tiles_checkpointed(checkpoint_path, {100, 64}, [&] (const ray_tracer_type::image_type& tile, const ray_tracer_type::image_size_type& offset)
+    {
+      for (auto y = 0; y < tile.size[1]; ++y)
+        for (auto x = 0; x < tile.size[0]; ++x)
+          checkpointed_image.data[(offset[0] + x) + (offset[1] + y) * image.size[0]] = tile.data[x + y * tile.size[0]];
+    });
+    if (ray_tracer.get_communicator().rank() == 0)
+      REQUIRE(checkpointed_image.data == image.data);
+  }
+  const auto scene_hash = ray_tracer.scene_hash();
+  ray_tracer.set_iterations(ray_tracer.get_iterations() + 1);
+  REQUIRE(ray_tracer.scene_hash() != scene_hash);
+  ray_tracer.set_iterations(ray_tracer.get_iterations() - 1);
+  REQUIRE(ray_tracer.scene_hash() == scene_hash);
+  if (ray_tracer.get_communicator().rank() == 0)
+    REQUIRE(ast::tile_checkpoint<float>(checkpoint_path, scene_hash, image.size, {100, 64}).finished_count() == 56);
+
+  // The render cache serves the frame and the endpoints of a known scene from disk: the entries of the first pass are
+  // read, not rewritten, by the second.
+  const std::filesystem::path render_cache("../data/outputs/tests/ray_tracer_test_cache");
+  std::filesystem::remove_all(render_cache);
+  ray_tracer.set_render_cache(render_cache);
+  std::vector<ray_tracer_type::image_type>     cached_images;
+  std::vector<std::filesystem::file_time_type> write_times  ;
+  for (auto pass = 0; pass < 2; ++pass)
+  {
+    const auto& cached_image     = ray_tracer.render_frame();
+    const auto  cached_endpoints = ray_tracer.render_endpoints();
+    if (ray_tracer.get_communicator().rank() == 0)
+    {
+      REQUIRE(cached_image.data == image.data);
+      cached_images.push_back(ray_tracer.shade(cached_endpoints));
+
+      std::vector<std::filesystem::file_time_type> times;
+      for (const auto& entry : std::filesystem::directory_iterator(render_cache))
+        times.push_back(entry.last_write_time());
+      std::sort(times.begin(), times.end());
+      write_times.insert(write_times.end(), times.begin(), times.end());
+    }
+  }
+  if (ray_tracer.get_communicator().rank() == 0)
+  {
+    REQUIRE(write_times.size() == 4); // Two entries per pass.
+    REQUIRE(write_times[0] == write_times[2]);
+    REQUIRE(write_times[1] == write_times[3]);
+    REQUIRE(cached_images[0].data == cached_images[1].data);
+  }
+  ray_tracer.set_render_cache(std::nullopt);
+
+  // Regions are rendered into the target in place, the remaining pixels are left as is.
+  const std::vector<ray_tracer_type::region_type> regions
+  {
+    ray_tracer_type::region_type(ray_tracer_type::image_size_type(200, 100), ray_tracer_type::image_size_type(440, 380)),
+    ray_tracer_type::region_type(ray_tracer_type::image_size_type(600, 440), ray_tracer_type::image_size_type(700, 500)) // Clamped.
+  };
+  ray_tracer_type::image_type region_image(image.size, ray_tracer_type::pixel_type(1, 2, 3));
+  ray_tracer.render_regions(region_image, regions);
+  mismatches = 0;
+  for (auto y = 0; y < image.size[1]; ++y)
+    for (auto x = 0; x < image.size[0]; ++x)
+    {
+      const auto inside = (x >= 200 && x < 440 && y >= 100 && y < 380) || (x >= 600 && y >= 440);
+      const auto index  = x + y * image.size[0];
+      if (region_image.data[index] != (inside ? image.data[index] : ray_tracer_type::pixel_type(1, 2, 3)))
+        ++mismatches;
+    }
+  if (ray_tracer.get_communicator().rank() == 0)
+    REQUIRE(mismatches == 0);
+
+  // Pipelined frames arrive one call late under MPI.
+  ray_tracer_type::image_type pipelined_image;
+  const auto first = ray_tracer.render_frame_pipelined(pipelined_image);
+#ifdef ASTRAY_USE_MPI
+  REQUIRE_THROWS(ray_tracer.set_load_weights({1.0f, 2.0f}, {2, 1})); // The partition is retained while a gather is in flight.
+#endif
+  const auto last  = ray_tracer.finish_pipeline       (pipelined_image);
+  if (ray_tracer.get_communicator().rank() == 0)
+  {
+    REQUIRE(first != last);
+    REQUIRE(pipelined_image.data == image.data);
+  }
+
+  // Frame-parallel rendering delivers the views in order, regardless of the ranks which rendered them.
+  std::vector<ray_tracer_type::image_type> temporal_views;
+  ray_tracer.render_frames_temporal({ray_tracer.get_observer().get_transform(), transform}, [&] (const ray_tracer_type::image_type& frame, const std::size_t index)
+  {
+    REQUIRE(index == temporal_views.size());
+    temporal_views.push_back(frame);
+  });
+  if (ray_tracer.get_communicator().rank() == 0)
+  {
+    REQUIRE(temporal_views.size()  == 2);
+    REQUIRE(temporal_views[0].data == views[0].data);
+    REQUIRE(temporal_views[1].data == views[1].data);
+  }
+
+  // A group of all ranks partitions each frame among them, covering it exactly even if the rank count does not divide it.
+  temporal_views.clear();
+  ray_tracer.render_frames_temporal({ray_tracer.get_observer().get_transform(), transform}, [&] (const ray_tracer_type::image_type& frame, const std::size_t)
+  {
+    temporal_views.push_back(frame);
+  }, ray_tracer.get_communicator().size());
+  if (ray_tracer.get_communicator().rank() == 0)
+  {
+    REQUIRE(temporal_views.size()  == 2);
+    REQUIRE(temporal_views[0].data == views[0].data);
+    REQUIRE(temporal_views[1].data == views[1].data);
+  }
+
+  // Run length coded gathers deliver the same frame.
+  ray_tracer.set_gather_compressed(true);
+  const auto& compressed_image = ray_tracer.render_frame();
+  if (ray_tracer.get_communicator().rank() == 0)
+    REQUIRE(compressed_image.data == image.data);
+  ray_tracer.set_gather_compressed(false);
+
+  // Node aware partitions are composited through the nodes into the same frame.
+  ray_tracer.set_node_aware(true);
+  const auto& node_aware_image = ray_tracer.render_frame();
+  if (ray_tracer.get_communicator().rank() == 0)
+    REQUIRE(node_aware_image.data == image.data);
+  ray_tracer.set_node_aware(false);
+
+  // Cost-weighted partitions differ in block sizes, but not in the gathered frame.
+  ray_tracer.balance_load();
+  const auto& balanced_image = ray_tracer.render_frame();
+  if (ray_tracer.get_communicator().rank() == 0)
+    REQUIRE(balanced_image.data == image.data);
+  ray_tracer.set_load_weights({}, {});
+
   if (ray_tracer.get_communicator().rank() == 0)
     image.save("../data/outputs/tests/ray_tracer_test.jpg");
   for (auto i = 1; i < ray_tracer.get_communicator().size(); ++i)
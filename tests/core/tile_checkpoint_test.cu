@@ -0,0 +1,91 @@
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <filesystem>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::tile_checkpoint")
+{
+  using checkpoint_type = ast::tile_checkpoint<float>;
+  using pixel_type      = checkpoint_type::pixel_type;
+  using image_type      = checkpoint_type::image_type;
+  using size_type       = checkpoint_type::size_type;
+  using endpoints_type  = checkpoint_type::endpoints_type;
+
+  const std::filesystem::path filepath("../data/outputs/tests/tile_checkpoint_test.bin");
+  const size_type             image_size(37, 23);
+  const size_type             tile_size (10, 8);
+  std::filesystem::remove(filepath);
+
+  const auto make_tile      = [&] (const checkpoint_type& checkpoint, const std::int32_t index)
+  {
+    image_type tile(checkpoint.tile_extent(index), pixel_type());
+    for (std::size_t i = 0; i < tile.data.size(); ++i)
+      tile.data[i] = pixel_type(static_cast<std::uint8_t>(index), static_cast<std::uint8_t>(i), static_cast<std::uint8_t>(i * 7));
+    return tile;
+  };
+  const auto make_endpoints = [&] (const checkpoint_type& checkpoint, const std::int32_t index)
+  {
+    endpoints_type endpoints(checkpoint.tile_extent(index));
+    for (std::size_t i = 0; i < endpoints.data.size(); ++i)
+    {
+      endpoints.data[i].theta       = static_cast<float>(index);
+      endpoints.data[i].phi         = static_cast<float>(i);
+      endpoints.data[i].termination = ast::termination_reason::none;
+    }
+    return endpoints;
+  };
+
+  // Partial tiles at the right and bottom edges.
+  {
+    checkpoint_type checkpoint(filepath, 42, image_size, tile_size, true);
+    REQUIRE(checkpoint.tile_count    () == 12);
+    REQUIRE(checkpoint.finished_count() == 0);
+    REQUIRE(checkpoint.tile_extent(11) == size_type(7, 7));
+
+    for (auto index = 0; index < 5; ++index)
+    {
+      const auto endpoints = make_endpoints(checkpoint, index);
+      checkpoint.write(index, make_tile(checkpoint, index), &endpoints);
+    }
+  }
+
+  // A torn record is discarded on resumption.
+  const auto size = std::filesystem::file_size(filepath);
+  std::filesystem::resize_file(filepath, size - 5);
+  {
+    checkpoint_type checkpoint(filepath, 42, image_size, tile_size, true);
+    REQUIRE(checkpoint.finished_count() == 4);
+    REQUIRE(!checkpoint.finished(4));
+    for (auto index = 0; index < 4; ++index)
+    {
+      REQUIRE(checkpoint.tile(index).data == make_tile(checkpoint, index).data);
+      REQUIRE(checkpoint.tile_endpoints(index).data[3].phi == 3.0f);
+    }
+
+    for (auto index = 4; index < checkpoint.tile_count(); ++index)
+    {
+      const auto endpoints = make_endpoints(checkpoint, index);
+      checkpoint.write(index, make_tile(checkpoint, index), &endpoints);
+    }
+    REQUIRE(checkpoint.finished_count() == 12);
+    REQUIRE(checkpoint.tile(11).data == make_tile(checkpoint, 11).data);
+
+    const auto endpoints = checkpoint.endpoints_of_image();
+    REQUIRE(endpoints.size == image_size);
+    REQUIRE(endpoints.at(size_type(36, 22)).theta == 11.0f);
+    REQUIRE(endpoints.at(size_type(36, 22)).phi   == 48.0f);
+  }
+
+  // A checkpoint of another scene or tiling is replaced.
+  {
+    checkpoint_type checkpoint(filepath, 43, image_size, tile_size, true);
+    REQUIRE(checkpoint.finished_count() == 0);
+  }
+  {
+    checkpoint_type checkpoint(filepath, 43, image_size, size_type(16, 16));
+    REQUIRE(checkpoint.finished_count() == 0);
+    REQUIRE(checkpoint.tile_count    () == 6);
+  }
+}
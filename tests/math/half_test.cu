@@ -0,0 +1,23 @@
+#include <doctest/doctest.h>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::half")
+{
+  REQUIRE(static_cast<float>(ast::half(0.0f     )) ==  0.0f     );
+  REQUIRE(static_cast<float>(ast::half(1.0f     )) ==  1.0f     );
+  REQUIRE(static_cast<float>(ast::half(-2.5f    )) == -2.5f     );
+  REQUIRE(static_cast<float>(ast::half(65504.0f )) ==  65504.0f );
+  REQUIRE(static_cast<float>(ast::half(0.000061035156f)) == 0.000061035156f); // Smallest normal.
+  REQUIRE(static_cast<float>(ast::half(5.9604645e-8f  )) == 5.9604645e-8f  ); // Smallest subnormal.
+  REQUIRE(std::isinf(static_cast<float>(ast::half(70000.0f))));
+  REQUIRE(std::isnan(static_cast<float>(ast::half(std::nanf("")))));
+
+  // Round to nearest even.
+  REQUIRE(static_cast<float>(ast::half(1.0f + 1.0f / 2048.0f)) == 1.0f);
+  REQUIRE(static_cast<float>(ast::half(1.0f + 3.0f / 2048.0f)) == 1.0f + 2.0f / 1024.0f);
+
+  // The relative error of the angles stored in endpoint buffers is within the precision of the format.
+  for (auto value = 0.0f; value < 6.3f; value += 0.001f)
+    REQUIRE(std::abs(static_cast<float>(ast::half(value)) - value) <= value / 2048.0f);
+}
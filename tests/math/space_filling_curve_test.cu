@@ -0,0 +1,35 @@
+#include <doctest/doctest.h>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::space_filling_curve")
+{
+  using size_type = ast::vector2<std::int32_t>;
+
+  for (std::size_t i = 0; i < 1024; ++i)
+  {
+    REQUIRE(ast::morton_encode (ast::morton_decode <size_type>(i    ))     == i);
+    REQUIRE(ast::hilbert_encode(ast::hilbert_decode<size_type>(i, 32), 32) == i);
+  }
+
+  // Consecutive indices along the Hilbert curve are neighbors.
+  for (std::size_t i = 1; i < 1024; ++i)
+    REQUIRE((ast::hilbert_decode<size_type>(i, 32) - ast::hilbert_decode<size_type>(i - 1, 32)).cwiseAbs().sum() == 1);
+
+  REQUIRE(ast::morton_decode<size_type>(0) == size_type(0, 0));
+  REQUIRE(ast::morton_decode<size_type>(1) == size_type(1, 0));
+  REQUIRE(ast::morton_decode<size_type>(2) == size_type(0, 1));
+  REQUIRE(ast::morton_decode<size_type>(3) == size_type(1, 1));
+
+  // The traversal order is a permutation of all indices, also for sizes which are not multiples of the tile size.
+  const size_type dimensions(100, 37);
+  for (const auto curve : {ast::space_filling_curve_type::row_major, ast::space_filling_curve_type::morton, ast::space_filling_curve_type::hilbert})
+  {
+    auto indices = ast::traversal_order<size_type, true>(dimensions, curve, 8);
+    REQUIRE(indices.size() == static_cast<std::size_t>(dimensions.prod()));
+    std::sort(indices.begin(), indices.end());
+    for (std::size_t i = 0; i < indices.size(); ++i)
+      REQUIRE(indices[i] == i);
+  }
+  REQUIRE_THROWS(ast::traversal_order<size_type, true>(dimensions, ast::space_filling_curve_type::morton, 6));
+}
@@ -0,0 +1,59 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::cubemap")
+{
+  using pixel_type   = ast::vector3<std::uint8_t>;
+  using image_type   = ast::image<pixel_type>;
+  using cubemap_type = ast::cubemap<pixel_type>;
+  using constants    = ast::constants<float>;
+
+  const image_type   image  ("../data/backgrounds/checkerboard.png");
+  const cubemap_type cubemap(image);
+
+  REQUIRE(cubemap.face_size() % cubemap_type::tile_size == 0);
+  REQUIRE(cubemap.face_size() >= image.size[0] / 4);
+  REQUIRE(cubemap.data().size() == 6 * static_cast<std::size_t>(cubemap.face_size()) * cubemap.face_size());
+
+  // The tiled layout is a permutation of the faces.
+  std::vector<bool> visited(cubemap.data().size(), false);
+  for (auto face = 0; face < 6; ++face)
+    for (auto v = 0; v < cubemap.face_size(); ++v)
+      for (auto u = 0; u < cubemap.face_size(); ++u)
+        visited[cubemap_type::texel_index(face, u, v, cubemap.face_size())] = true;
+  REQUIRE(std::find(visited.begin(), visited.end(), false) == visited.end());
+
+  // Random directions sample (nearly) the same colors as the equirectangular image. Directions within a texel of an edge
+  // of the checkerboard may differ due to the nearest resampling.
+  std::mt19937                    generator   (0);
+  std::normal_distribution<float> distribution;
+  constexpr auto                  samples     = 10000;
+  auto                            mismatches  = 0;
+  for (auto i = 0; i < samples; ++i)
+  {
+    ast::vector4<float> direction(0.0f, distribution(generator), distribution(generator), distribution(generator));
+    const auto& sample = cubemap_type::sample(cubemap.data().data(), cubemap.face_size(), direction[1], direction[2], direction[3]);
+
+    ast::convert<ast::coordinate_system_type::cartesian, ast::coordinate_system_type::spherical>(direction);
+    ast::vector2<std::int32_t> index(
+      static_cast<std::int32_t>(std::floor(direction[3] / constants::two_pi * image.size[0])),
+      static_cast<std::int32_t>(std::floor(direction[2] / constants::pi     * image.size[1])));
+    if (index[1] == image.size[1]) --index[1];
+
+    if (sample != image.data[ast::ravel_multi_index<ast::vector2<std::int32_t>, true>(index, image.size)])
+      ++mismatches;
+  }
+  REQUIRE(mismatches < samples / 50);
+
+  // Axis directions select the faces in order.
+  REQUIRE(&cubemap_type::sample(cubemap.data().data(), cubemap.face_size(),  1.0f, 0.0f, 0.0f) < cubemap.data().data() + 1 * cubemap.data().size() / 6);
+  REQUIRE(&cubemap_type::sample(cubemap.data().data(), cubemap.face_size(),  0.0f, 0.0f,-1.0f) >= cubemap.data().data() + 5 * cubemap.data().size() / 6);
+}
@@ -0,0 +1,26 @@
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::mapped_image")
+{
+  using pixel_type        = ast::vector3<std::uint8_t>;
+  using image_type        = ast::image<pixel_type>;
+  using mapped_image_type = ast::mapped_image<pixel_type>;
+
+  const image_type image("../data/backgrounds/checkerboard.png");
+
+  std::filesystem::remove("../data/outputs/tests/mapped_image_test.raw");
+  for (auto i = 0; i < 2; ++i) // Creates the cache, then maps the existing one.
+  {
+    const auto mapped = mapped_image_type::load_cached("../data/backgrounds/checkerboard.png", "../data/outputs/tests/mapped_image_test.raw");
+    REQUIRE(std::filesystem::exists("../data/outputs/tests/mapped_image_test.raw"));
+    REQUIRE(mapped.size == image.size);
+    REQUIRE(std::memcmp(mapped.data(), image.data.data(), image.data.size() * sizeof(pixel_type)) == 0);
+    REQUIRE(mapped.to_image().data == image.data);
+  }
+}
@@ -0,0 +1,42 @@
+#include <doctest/doctest.h>
+
+#include <cmath>
+#include <cstdint>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::mip_pyramid")
+{
+  using pixel_type       = ast::vector3<std::uint8_t>;
+  using image_type       = ast::image<pixel_type>;
+  using mip_pyramid_type = ast::mip_pyramid<pixel_type>;
+  using constants        = ast::constants<float>;
+
+  image_type image({8, 4});
+  for (auto y = 0; y < 4; ++y)
+    for (auto x = 0; x < 8; ++x)
+      image.data[x + y * 8] = (x + y) % 2 == 0 ? pixel_type(255, 255, 255) : pixel_type(0, 0, 0);
+
+  const mip_pyramid_type pyramid(image);
+  REQUIRE(pyramid.level_count() == 4);
+  REQUIRE(pyramid.level(0).data == image.data);
+  REQUIRE(pyramid.level(1).size == ast::vector2<std::int32_t>(4, 2));
+  REQUIRE(pyramid.level(3).size == ast::vector2<std::int32_t>(1, 1));
+  REQUIRE(pyramid.data().size() == 8 * 4 + 4 * 2 + 2 * 1 + 1 * 1);
+  for (const auto& pixel : pyramid.level(1).data)
+    REQUIRE(pixel == pixel_type(128, 128, 128)); // Box filtered checkerboard.
+
+  // Level 0 matches the nearest lookup, fractional levels blend between the two nearest levels.
+  for (auto y = 0; y < 4; ++y)
+    for (auto x = 0; x < 8; ++x)
+    {
+      const auto theta = (static_cast<float>(y) + 0.5f) / 4 * constants::pi;
+      const auto phi   = (static_cast<float>(x) + 0.5f) / 8 * constants::two_pi;
+      REQUIRE(mip_pyramid_type::sample(pyramid.data().data(), pyramid.size(), pyramid.level_count(), theta, phi, 0.0f) == image.data[x + y * 8]);
+      REQUIRE(mip_pyramid_type::sample(pyramid.data().data(), pyramid.size(), pyramid.level_count(), theta, phi, std::nanf("")) == image.data[x + y * 8]);
+      REQUIRE(mip_pyramid_type::sample(pyramid.data().data(), pyramid.size(), pyramid.level_count(), theta, phi, 1.0f) == pixel_type(128, 128, 128));
+      REQUIRE(mip_pyramid_type::sample(pyramid.data().data(), pyramid.size(), pyramid.level_count(), theta, phi, 100.0f) == pyramid.level(3).data[0]);
+    }
+  const auto half = mip_pyramid_type::sample(pyramid.data().data(), pyramid.size(), pyramid.level_count(), 0.1f, 0.1f, 0.5f);
+  REQUIRE(half[0] == static_cast<std::uint8_t>(std::round(0.5f * 255 + 0.5f * 128)));
+}
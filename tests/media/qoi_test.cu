@@ -0,0 +1,68 @@
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::qoi")
+{
+  constexpr std::uint32_t width  = 123;
+  constexpr std::uint32_t height = 77;
+
+  // Gradients, runs, noise and alpha changes to exercise all operations.
+  std::vector<std::uint8_t> data(width * height * 4);
+  std::uint32_t             state = 1;
+  for (std::uint32_t y = 0; y < height; ++y)
+    for (std::uint32_t x = 0; x < width; ++x)
+    {
+      state = state * 1664525u + 1013904223u;
+      auto* pixel = data.data() + (x + y * width) * 4;
+      if      (y < 20) { pixel[0] = static_cast<std::uint8_t>(x); pixel[1] = static_cast<std::uint8_t>(y); pixel[2] = 128; pixel[3] = 255; }
+      else if (y < 40) { pixel[0] = 10; pixel[1] = 20; pixel[2] = 30; pixel[3] = 255; }
+      else if (y < 60) { pixel[0] = static_cast<std::uint8_t>(state >> 24); pixel[1] = static_cast<std::uint8_t>(state >> 16); pixel[2] = static_cast<std::uint8_t>(state >> 8); pixel[3] = 255; }
+      else             { pixel[0] = static_cast<std::uint8_t>(x * 3); pixel[1] = static_cast<std::uint8_t>(x * 2); pixel[2] = static_cast<std::uint8_t>(x); pixel[3] = static_cast<std::uint8_t>(x % 2 ? 255 : 128); }
+    }
+
+  for (const std::size_t band_count : {1, 2, 7, 77, 1000})
+  {
+    std::uint32_t decoded_width, decoded_height;
+
+    const auto encoded = ast::qoi::encode(data.data(), width, height, 4, band_count);
+    REQUIRE(ast::qoi::decode(encoded.data(), encoded.size(), decoded_width, decoded_height, 4) == data);
+    REQUIRE(decoded_width  == width );
+    REQUIRE(decoded_height == height);
+
+    std::vector<std::uint8_t> rgb;
+    for (std::size_t i = 0; i < data.size(); ++i)
+      if (i % 4 != 3)
+        rgb.push_back(data[i]);
+    const auto encoded_rgb = ast::qoi::encode(rgb.data(), width, height, 3, band_count);
+    REQUIRE(ast::qoi::decode(encoded_rgb.data(), encoded_rgb.size(), decoded_width, decoded_height, 3) == rgb);
+    REQUIRE(encoded_rgb.size() < rgb.size());
+  }
+
+  // Headers with zero, oversized or overflowing dimensions are rejected before allocating.
+  for (const auto& [corrupt_width, corrupt_height] : std::vector<std::pair<std::uint32_t, std::uint32_t>>{{0, 1}, {1, 0}, {20001, 20000}, {1u << 31, 1u << 31}, {0xFFFFFFFF, 2}})
+  {
+    auto corrupt = ast::qoi::encode(data.data(), width, height, 4, 1);
+    for (auto i = 0; i < 4; ++i)
+    {
+      corrupt[4 + i] = static_cast<std::uint8_t>(corrupt_width  >> (24 - 8 * i));
+      corrupt[8 + i] = static_cast<std::uint8_t>(corrupt_height >> (24 - 8 * i));
+    }
+
+    std::uint32_t decoded_width, decoded_height;
+    REQUIRE_THROWS(ast::qoi::decode(corrupt.data(), corrupt.size(), decoded_width, decoded_height, 4));
+  }
+
+  using pixel_type = ast::vector3<std::uint8_t>;
+  using image_type = ast::image<pixel_type>;
+
+  const image_type image("../data/backgrounds/checkerboard.png");
+  image.save("../data/outputs/tests/qoi_test.qoi");
+  const image_type other("../data/outputs/tests/qoi_test.qoi");
+  REQUIRE(image.size == other.size);
+  REQUIRE(image.data == other.data);
+}
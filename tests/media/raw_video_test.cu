@@ -0,0 +1,48 @@
+#include <doctest/doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::raw_video")
+{
+  using pixel_type = ast::vector3<std::uint8_t>;
+  using frame_type = ast::image<pixel_type>;
+
+  const std::string header = "YUV4MPEG2 W255 H127 F60:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n";
+  const std::size_t planes = 255 * 127 + 2 * (128 * 64);
+
+  {
+    ast::raw_video video("../data/outputs/tests/raw_video_test.y4m", {255, 127}, 60);
+    video.append(frame_type({255, 127}, pixel_type(255, 255, 255)));
+    video.append(frame_type({255, 127}, pixel_type(0  , 0  , 255)));
+  }
+  {
+    std::ifstream             stream("../data/outputs/tests/raw_video_test.y4m", std::ios::binary);
+    std::vector<std::uint8_t> data  ((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    REQUIRE(data.size() == header.size() + 2 * (6 + planes));
+    REQUIRE(std::string(data.begin(), data.begin() + header.size()) == header);
+
+    const auto white = header.size() + 6;
+    REQUIRE(data[white                        ] == 255); // Y
+    REQUIRE(data[white + 255 * 127            ] == 128); // Cb
+    REQUIRE(data[white + 255 * 127 + 128 * 64 ] == 128); // Cr
+
+    const auto blue = white + planes + 6;
+    REQUIRE(data[blue                         ] == 29 );
+    REQUIRE(data[blue + 255 * 127             ] == 255);
+    REQUIRE(data[blue + 255 * 127 + 128 * 64  ] == 107);
+  }
+
+  {
+    ast::raw_video video("../data/outputs/tests/raw_video_test.rgb", {255, 127}, 60, ast::raw_video_format::rgb);
+    video.append(frame_type({255, 127}, pixel_type(1, 2, 3)));
+  }
+  REQUIRE(std::filesystem::file_size("../data/outputs/tests/raw_video_test.rgb") == 255 * 127 * 3);
+}
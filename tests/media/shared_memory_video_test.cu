@@ -0,0 +1,75 @@
+#include <doctest/doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::shared_memory_video")
+{
+  using pixel_type = ast::vector3<std::uint8_t>;
+  using frame_type = ast::image<pixel_type>;
+
+  ast::shared_memory_video        video ("/astray_shared_memory_video_test", {64, 32}, 2);
+  ast::shared_memory_video_reader reader("/astray_shared_memory_video_test");
+  REQUIRE(reader.get_size() == ast::vector2<std::int32_t>(64, 32));
+
+  frame_type    frame;
+  std::uint64_t frame_index = 0;
+  REQUIRE(!reader.read(frame));
+
+  video.append(frame_type({64, 32}, pixel_type(0, 0, 0)));
+  REQUIRE( reader.read(frame, &frame_index));
+  REQUIRE( frame_index   == 0);
+  REQUIRE( frame.data[0] == pixel_type(0, 0, 0));
+  REQUIRE(!reader.read(frame)); // No new frame.
+
+  // The writer never waits for the reader, the unread frame 1 is overwritten by frame 3.
+  for (auto i = 1; i < 4; ++i)
+    video.append(frame_type({64, 32}, pixel_type(i, i, i)));
+  REQUIRE(video.get_dropped_frame_count() == 1);
+
+  REQUIRE(reader.read_in_place([&] (const pixel_type* pixels, const std::uint64_t index, std::int64_t timestamp)
+  {
+    frame_index = index;
+    REQUIRE(pixels[64 * 32 - 1] == pixel_type(3, 3, 3));
+    REQUIRE(timestamp > 0);
+  }));
+  REQUIRE(frame_index == 3);
+}
+
+TEST_CASE("ast::shared_memory_video_reader rejects inconsistent layouts")
+{
+  using header = ast::shared_memory_video_layout::header;
+
+  const auto make_segment = [ ] (const std::size_t size, const std::uint32_t slot_count, const std::uint64_t slot_stride)
+  {
+    ast::shared_memory memory("/astray_shared_memory_video_layout_test", size);
+    auto* shared_header        = new (memory.data()) header;
+    shared_header->slot_count  = slot_count;
+    shared_header->size[0]     = 64;
+    shared_header->size[1]     = 32;
+    shared_header->slot_stride = slot_stride;
+    return memory;
+  };
+
+  const auto offset = ast::shared_memory_video_layout::align(sizeof(header));
+  const auto stride = ast::shared_memory_video_layout::align(sizeof(ast::shared_memory_video_layout::slot_header) + 64 * 32 * 3);
+  {
+    auto memory = make_segment(offset + 2 * stride, 2, stride);
+    REQUIRE(ast::shared_memory_video_reader("/astray_shared_memory_video_layout_test").get_size() == ast::vector2<std::int32_t>(64, 32));
+  }
+  {
+    auto memory = make_segment(offset + 2 * stride, 3, stride); // More slots than mapped.
+    REQUIRE_THROWS(ast::shared_memory_video_reader("/astray_shared_memory_video_layout_test"));
+  }
+  {
+    auto memory = make_segment(offset + 2 * stride, 1, 64); // Slots smaller than a frame.
+    REQUIRE_THROWS(ast::shared_memory_video_reader("/astray_shared_memory_video_layout_test"));
+  }
+  {
+    auto memory = make_segment(offset + 2 * stride, 0xFFFFFFFF, std::uint64_t(1) << 63); // Overflowing layout.
+    REQUIRE_THROWS(ast::shared_memory_video_reader("/astray_shared_memory_video_layout_test"));
+  }
+}
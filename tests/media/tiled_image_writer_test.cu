@@ -0,0 +1,50 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::tiled_image_writer")
+{
+  using pixel_type = ast::tiled_image_writer::pixel_type;
+  using image_type = ast::tiled_image_writer::image_type;
+  using size_type  = ast::tiled_image_writer::size_type;
+
+  image_type image({37, 23});
+  for (std::size_t i = 0; i < image.data.size(); ++i)
+    image.data[i] = pixel_type(static_cast<std::uint8_t>(i % 251), static_cast<std::uint8_t>(i * 7), static_cast<std::uint8_t>(i * 13));
+
+  // Partial tiles at the right and bottom edges.
+  const size_type tile_size(10, 8);
+  const auto      write = [&] (ast::tiled_image_writer& writer)
+  {
+    for (auto y = 0; y < image.size[1]; y += tile_size[1])
+      for (auto x = 0; x < image.size[0]; x += tile_size[0])
+      {
+        image_type tile(size_type(std::min(tile_size[0], image.size[0] - x), std::min(tile_size[1], image.size[1] - y)));
+        for (auto j = 0; j < tile.size[1]; ++j)
+          for (auto i = 0; i < tile.size[0]; ++i)
+            tile.data[i + j * tile.size[0]] = image.data[(x + i) + (y + j) * image.size[0]];
+        writer.write(tile, size_type(x, y));
+      }
+    writer.close();
+  };
+
+  {
+    ast::tiled_image_writer writer("../data/outputs/tests/tiled_image_writer_test.raw", image.size, ast::tiled_image_format::raw);
+    write(writer);
+    REQUIRE(ast::mapped_image<pixel_type>("../data/outputs/tests/tiled_image_writer_test.raw").to_image().data == image.data);
+  }
+  {
+    ast::tiled_image_writer writer("../data/outputs/tests/tiled_image_writer_test.png", image.size, ast::tiled_image_format::png);
+    write(writer);
+    const image_type decoded("../data/outputs/tests/tiled_image_writer_test.png");
+    REQUIRE(decoded.size == image.size);
+    REQUIRE(decoded.data == image.data);
+  }
+  {
+    ast::tiled_image_writer writer("../data/outputs/tests/tiled_image_writer_test.png", image.size, ast::tiled_image_format::png);
+    REQUIRE_THROWS(writer.write(image_type(tile_size), size_type(0, 8))); // Stripes have to arrive in order.
+  }
+}
@@ -1,5 +1,8 @@
 #include <doctest/doctest.h>
 
+#include <cstdint>
+#include <vector>
+
 #include <astray/api.hpp>
 
 TEST_CASE("ast::mpi")
@@ -15,5 +18,22 @@ TEST_CASE("ast::mpi")
 
     MPI_Bcast(&value, 1, MPI_INT, 0, communicator.native());
     REQUIRE(value == 42);
+
+    // The table of rank 0 is readable by all ranks through the shared window of their node.
+    std::vector<std::int32_t> table;
+    if (communicator.rank() == 0)
+      for (auto i = 0; i < 1000; ++i)
+        table.push_back(i * i);
+
+    auto window = ast::mpi::share(communicator, table.data(), table.size());
+    REQUIRE(window.size() == 1000);
+    auto mismatches = 0;
+    for (auto i = 0; i < 1000; ++i)
+      if (window.data()[i] != i * i)
+        ++mismatches;
+    REQUIRE(mismatches == 0);
+
+    const auto node = communicator.split_shared();
+    REQUIRE(node.size() <= communicator.size());
   }
 }
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::run_length")
+{
+  constexpr std::size_t count        = 1000;
+  constexpr std::size_t element_size = 3;
+
+  // Uniform regions, gradients, noise and runs longer than a single token.
+  std::vector<std::uint8_t> data(count * element_size);
+  std::uint32_t             state = 1;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    state = state * 1664525u + 1013904223u;
+    auto* element = data.data() + i * element_size;
+    if      (i < 300) { element[0] = 0; element[1] = 0; element[2] = 0; }
+    else if (i < 500) { element[0] = static_cast<std::uint8_t>(i); element[1] = static_cast<std::uint8_t>(2 * i); element[2] = 7; }
+    else if (i < 700) { element[0] = static_cast<std::uint8_t>(state >> 24); element[1] = static_cast<std::uint8_t>(state >> 16); element[2] = static_cast<std::uint8_t>(state >> 8); }
+    else              { element[0] = 255; element[1] = static_cast<std::uint8_t>(i / 50); element[2] = 0; }
+  }
+
+  for (const auto delta : {false, true})
+  {
+    const auto encoded = ast::run_length::encode(data.data(), count, element_size, delta);
+    REQUIRE(encoded.size() < data.size());
+
+    std::vector<std::uint8_t> decoded(data.size());
+    ast::run_length::decode(encoded.data(), encoded.size(), count, element_size, decoded.data(), delta);
+    REQUIRE(decoded == data);
+
+    REQUIRE_THROWS(ast::run_length::decode(encoded.data(), encoded.size() / 2, count, element_size, decoded.data(), delta));
+  }
+
+  // The gradient becomes a single run through the delta coding.
+  REQUIRE(ast::run_length::encode(data.data() + 300 * element_size, 100, element_size, true ).size() < 10);
+  REQUIRE(ast::run_length::encode(data.data() + 300 * element_size, 100, element_size, false).size() > 300);
+
+  const auto empty = ast::run_length::encode(nullptr, 0, element_size);
+  REQUIRE(empty.empty());
+  ast::run_length::decode(empty.data(), 0, 0, element_size, nullptr);
+}
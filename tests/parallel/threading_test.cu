@@ -0,0 +1,48 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::threading")
+{
+  // The ranks of a node share its processors, each rank runs at least one thread.
+  for (const auto affinity : {ast::thread_affinity::none, ast::thread_affinity::compact, ast::thread_affinity::spread, ast::thread_affinity::socket})
+    for (std::int32_t rank = 0; rank < 4; ++rank)
+    {
+      const auto processors = ast::threading::processors(affinity, rank, 4);
+      REQUIRE(!processors.empty());
+      REQUIRE(processors.size() <= std::max<std::size_t>(std::thread::hardware_concurrency() / 4, 1));
+      REQUIRE(ast::threading::processors(affinity, rank, 4, 3).size() == 3);
+    }
+
+  // Candidates are taken from the affinity mask of the process.
+  const auto& available = ast::threading::available_processors();
+  for (const auto processor : ast::threading::processors(ast::thread_affinity::compact, 0, 1))
+    REQUIRE(std::find(available.begin(), available.end(), processor) != available.end());
+
+  REQUIRE(ast::threading::configure(ast::thread_affinity::compact, 0, 1, 2) == 2);
+#if defined(_OPENMP) && defined(__linux__)
+  // The calling thread is not pinned to a single processor, and none restores the original mask.
+  const auto processor_count = [ ]
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    sched_getaffinity(0, sizeof(set), &set);
+    return CPU_COUNT(&set);
+  };
+  if (available.size() > 1)
+    REQUIRE(processor_count() == 2);
+#endif
+  REQUIRE(ast::threading::configure(ast::thread_affinity::none   , 0, 1   ) >= 1);
+#if defined(_OPENMP) && defined(__linux__)
+  REQUIRE(processor_count() == static_cast<std::int32_t>(available.size()));
+#endif
+
+  // First touch preserves the size and sets the value, regardless of the previous contents.
+  std::vector<std::int32_t> data(1 << 20, 1);
+  ast::threading::first_touch(data.data(), data.size(), 42);
+  REQUIRE(std::count(data.begin(), data.end(), 42) == static_cast<std::ptrdiff_t>(data.size()));
+}
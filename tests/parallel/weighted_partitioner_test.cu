@@ -0,0 +1,100 @@
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <astray/api.hpp>
+
+TEST_CASE("ast::weighted_partitioner")
+{
+  using pixel_type       = ast::vector3<std::uint8_t>;
+  using size_type        = ast::vector2<std::int32_t>;
+  using partitioner_type = ast::weighted_partitioner<2, std::int32_t, size_type, true>;
+
+  const size_type    domain_size  = {640, 480};
+  const size_type    weights_size = {16 , 12 };
+  const std::int32_t ranks        = 8;
+
+  // An expensive region off the center, such as the shadow of a black hole.
+  std::vector<float> weights(weights_size.prod(), 1.0f);
+  for (auto y = 4; y < 8; ++y)
+    for (auto x = 6; x < 10; ++x)
+      weights[x + y * weights_size[0]] = 50.0f;
+
+  // Without weights, the partition matches the equal partitioner.
+  for (std::int32_t i = 0; i < ranks; ++i)
+  {
+    const partitioner_type                                  weighted(i, ranks, domain_size);
+    const ast::partitioner<2, std::int32_t, size_type, true> equal   (i, ranks, domain_size);
+    REQUIRE(weighted.block_size () == equal.block_size ());
+    REQUIRE(weighted.rank_offset() == equal.rank_offset());
+  }
+
+  // The blocks cover the domain without overlaps, at roughly equal costs.
+  ast::image<pixel_type> domain(domain_size, pixel_type(0, 0, 0));
+  std::vector<std::int32_t> owners(domain_size.prod(), -1);
+  std::vector<double>       costs (ranks, 0.0);
+  auto                      overlaps = 0;
+  for (std::int32_t i = 0; i < ranks; ++i)
+  {
+    const partitioner_type partitioner(i, ranks, domain_size, weights, weights_size);
+    REQUIRE(partitioner.weighted());
+    REQUIRE(partitioner.block_offsets()[i] == partitioner.rank_offset());
+    REQUIRE(partitioner.block_sizes  ()[i] == partitioner.block_size ());
+    for (std::int32_t x = 0; x < partitioner.block_size()[0]; ++x)
+      for (std::int32_t y = 0; y < partitioner.block_size()[1]; ++y)
+      {
+        const size_type index(partitioner.rank_offset()[0] + x, partitioner.rank_offset()[1] + y);
+        if (owners[index[0] + index[1] * domain_size[0]] != -1)
+          ++overlaps;
+        owners[index[0] + index[1] * domain_size[0]] = i;
+        costs [i] += weights[index[0] * weights_size[0] / domain_size[0] + index[1] * weights_size[1] / domain_size[1] * weights_size[0]];
+        domain.at(index) = pixel_type::Constant(static_cast<std::uint8_t>(255.0 * i / ranks));
+      }
+  }
+  REQUIRE(overlaps == 0);
+  REQUIRE(std::count(owners.begin(), owners.end(), -1) == 0);
+  const auto [minimum, maximum] = std::minmax_element(costs.begin(), costs.end());
+  REQUIRE(*maximum < 1.1 * *minimum);
+
+  // Node aware partitions split the domain into bands, and the bands of each node form a contiguous stripe.
+  const std::vector<std::int32_t> nodes {0, 1, 0, 1, 2, 2, 0, 1};
+  for (const auto& node_weights : {std::vector<float>(), weights})
+  {
+    std::vector<std::int32_t> rows(domain_size[1], -1);
+    for (std::int32_t i = 0; i < ranks; ++i)
+    {
+      partitioner_type partitioner(i, ranks, domain_size, node_weights, weights_size);
+      partitioner.set_nodes(nodes);
+      REQUIRE(partitioner.node_aware());
+      REQUIRE(!partitioner.uniform());
+      REQUIRE(partitioner.rank_offset()[0] == 0);
+      REQUIRE(partitioner.block_size ()[0] == domain_size[0]);
+      REQUIRE(partitioner.block_size ()[1] >  0);
+      for (std::int32_t y = 0; y < partitioner.block_size()[1]; ++y)
+      {
+        REQUIRE(rows[partitioner.rank_offset()[1] + y] == -1);
+        rows[partitioner.rank_offset()[1] + y] = nodes[i];
+      }
+    }
+    REQUIRE(std::count(rows.begin(), rows.end(), -1) == 0);
+    REQUIRE(std::is_sorted(rows.begin(), rows.end()));
+  }
+
+  // Unit weights cover tiles exactly where the equal blocks miss the remainder (see ray_tracer::render_tile).
+  for (const auto& tile_size : {size_type(40, 32), size_type(240, 280), size_type(7, 5), size_type(1, 1)})
+    for (std::int32_t tile_ranks = 2; tile_ranks <= 7; ++tile_ranks)
+    {
+      std::vector<std::int32_t> coverage(tile_size.prod(), 0);
+      for (std::int32_t i = 0; i < tile_ranks; ++i)
+      {
+        const partitioner_type partitioner(i, tile_ranks, tile_size, {1.0f}, size_type(1, 1));
+        for (std::int32_t y = 0; y < partitioner.block_size()[1]; ++y)
+          for (std::int32_t x = 0; x < partitioner.block_size()[0]; ++x)
+            ++coverage[(partitioner.rank_offset()[0] + x) + (partitioner.rank_offset()[1] + y) * tile_size[0]];
+      }
+      REQUIRE(std::count(coverage.begin(), coverage.end(), 1) == tile_size.prod());
+    }
+
+  domain.save("../data/outputs/tests/weighted_partitioner_test.jpg");
+}